@@ -6,7 +6,33 @@
 #include <sstream>
 #include <algorithm>
 #include <chrono>
-#include <unordered_map>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <exception>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+#define PEXT_SUPPORTED 1
+#if !defined(_MSC_VER)
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+#else
+#define PEXT_SUPPORTED 0
+#endif
 
 template <typename T>
 T customMin(T a, T b) {
@@ -18,47 +44,129 @@ T customMax(T a, T b) {
     return (a > b) ? a : b;
 }
 
-struct Move {
-    std::string notation;
-    bool isCastling = false;
-    bool isKingsideCastling = false;
-    bool isEnPassant = false;
-    int enPassantCapturePos = -1;
+typedef uint64_t Bitboard;
+
+enum PieceType {
+    PAWN = 0,
+    KNIGHT = 1,
+    BISHOP = 2,
+    ROOK = 3,
+    QUEEN = 4,
+    KING = 5,
+    NO_PIECE_TYPE = 6
 };
 
-struct TTEntry {
-    uint64_t zobristKey;     
-    int depth;               
-    int flag;                
-    int score;               
-    Move bestMove;           
+enum MoveFlag : uint16_t {
+    NORMAL_MOVE = 0,
+    PROMOTION = 1 << 14,
+    EN_PASSANT = 2 << 14,
+    CASTLING = 3 << 14
 };
 
-struct MoveTreeNode {
-    Move move;
-    std::string boardState;           
-    int evaluation = 0;                 
-    bool isEvaluated = false;           
-    std::vector<MoveTreeNode*> children;
-    MoveTreeNode* parent = nullptr;
+enum MoveGenType {
+    ALL_MOVES = 0,
+    CAPTURES = 1,
+    QUIETS = 2
+};
 
-    MoveTreeNode(const std::string& state) :
-        boardState(state) {
+// bits 0-5: from square, 6-11: to square, 12-13: promotion piece - KNIGHT, 14-15: MoveFlag
+struct Move {
+    uint16_t data = 0;
+
+    Move() = default;
+
+    Move(int from, int to, uint16_t flag = NORMAL_MOVE, int promotion = KNIGHT) :
+        data((uint16_t)(from | (to << 6) | ((promotion - KNIGHT) << 12) | flag)) {
     }
 
-    MoveTreeNode(const std::string& state, const Move& m, MoveTreeNode* p) :
-        boardState(state), move(m), parent(p) {
+    int From() const { return data & 0x3F; }
+    int To() const { return (data >> 6) & 0x3F; }
+    int Promotion() const { return ((data >> 12) & 0x3) + KNIGHT; }
+    uint16_t Flag() const { return data & (0x3 << 14); }
+
+    bool IsNull() const { return data == 0; }
+    bool IsPromotion() const { return Flag() == PROMOTION; }
+    bool IsEnPassant() const { return Flag() == EN_PASSANT; }
+    bool IsCastling() const { return Flag() == CASTLING; }
+    bool IsKingsideCastling() const { return IsCastling() && To() > From(); }
+    int EnPassantCapturePos() const { return To() + (From() > To() ? 8 : -8); }
+
+    bool operator==(const Move& other) const { return data == other.data; }
+    bool operator!=(const Move& other) const { return data != other.data; }
+};
+
+const int MAX_MOVES = 256;
+
+// Fixed-capacity move list with a score per move, kept on the stack so movegen never allocates
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    int count = 0;
+
+    void push_back(const Move& move) {
+        moves[count++] = move;
+    }
+
+    void push_back(const Move& move, int score) {
+        int i = count++;
+        moves[i] = move;
+        scores[i] = score;
     }
 
-    ~MoveTreeNode() {
-        for (MoveTreeNode* child : children) {
-            delete child;
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move PickBest(int index) {
+        int best = index;
+        for (int i = index + 1; i < count; i++) {
+            if (scores[i] > scores[best]) best = i;
         }
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+        return moves[index];
     }
 };
 
+// 12 bytes: upper half of the key, score, move, depth, and generation (high 6 bits) + bound (low 2 bits)
+struct TTEntry {
+    uint32_t key32;
+    int32_t score;
+    Move bestMove;
+    int8_t depth;
+    uint8_t genBound;
+};
+
+const int TT_BUCKET_SIZE = 5;
+
+// One cache line per probe
+struct alignas(64) TTBucket {
+    TTEntry entries[TT_BUCKET_SIZE];
+};
+static_assert(sizeof(TTBucket) == 64, "TTBucket must fill exactly one cache line");
+
+const int SCALE_NORMAL = 64;
+
+// Everything that depends only on the piece counts, looked up by BoardPosition::materialKey
+struct MaterialEntry {
+    uint64_t key;
+    int score;
+    int gamePhase;
+    bool isDrawn;
+    uint8_t scale[2];
+};
+
 struct BoardPosition {
-    std::string boardState;
+    char boardState[64];
+    Bitboard pieceBitboards[2][6];
+    Bitboard colorBitboards[2];
+    Bitboard occupied;
     bool whiteCanCastleKingside;
     bool whiteCanCastleQueenside;
     bool blackCanCastleKingside;
@@ -67,6 +175,77 @@ struct BoardPosition {
     int halfMoveClock;
     int fullMoveNumber;
     bool whiteToMove;
+    uint64_t hash;
+    uint64_t pawnHash;
+    uint64_t materialKey;
+};
+
+struct UndoRecord {
+    Move move;
+    char capturedPiece;
+    bool whiteCanCastleKingside;
+    bool whiteCanCastleQueenside;
+    bool blackCanCastleKingside;
+    bool blackCanCastleQueenside;
+    int enPassantTargetSquare;
+    int halfMoveClock;
+    uint64_t hash;
+    uint64_t pawnHash;
+    char movedPiece;
+};
+
+// Nodes refer to each other by arena index; a node's children occupy one contiguous index range
+struct MoveTreeNode {
+    Move move;
+    int evaluation = 0;                 
+    bool isEvaluated = false;           
+    int parent = -1;
+    int firstChild = 0;
+    int childCount = 0;
+};
+
+// Bump allocator for tree nodes; Reset releases the whole tree at once and keeps the capacity
+struct MoveTreeArena {
+    std::vector<MoveTreeNode> nodes;
+
+    int Allocate(const Move& move, int parent) {
+        MoveTreeNode node;
+        node.move = move;
+        node.parent = parent;
+        nodes.push_back(node);
+        return (int)nodes.size() - 1;
+    }
+
+    void Reset() { nodes.clear(); }
+    int Size() const { return (int)nodes.size(); }
+    MoveTreeNode& operator[](int index) { return nodes[index]; }
+};
+
+enum PickerStage {
+    TT_MOVE_STAGE = 0,
+    GOOD_CAPTURES_STAGE = 1,
+    KILLERS_STAGE = 2,
+    QUIETS_STAGE = 3,
+    BAD_CAPTURES_STAGE = 4,
+    PICKER_DONE = 5
+};
+
+// Yields legal moves one stage at a time so a cutoff skips generating the later stages
+struct MovePicker {
+    const BoardPosition& position;
+    bool isWhite;
+    int ply;
+    Move ttMove;
+    Move counterMove;
+    int stage = TT_MOVE_STAGE;
+    int index = 0;
+    bool generated = false;
+    MoveList moves;
+    MoveList badCaptures;
+
+    MovePicker(const BoardPosition& pos, bool white, int pickerPly, const Move& tt);
+
+    Move Next();
 };
 
 const int TT_EXACT = 0;
@@ -74,7 +253,82 @@ const int TT_ALPHA = 1;
 const int TT_BETA = 2;
 
 const int MAX_PLY = 64;
-Move killerMoves[MAX_PLY][2] = {};
+// Leaves room below MAX_PLY for the quiescence plies under the deepest full-width node
+const int MAX_SEARCH_DEPTH = 32;
+// Search bounds stay far inside int so window arithmetic such as -alpha - 1 can never overflow
+const int INFINITE_SCORE = 1000000;
+// Mated at remaining depth d scores -(MATE_SCORE + 100 * d); anything beyond +-90000 is treated as decisive
+const int MATE_SCORE = 100000;
+const int NO_EVAL = -2147483647;
+// Side-to-move static eval by undoDepth, NO_EVAL when that node was in check
+thread_local int staticEvalStack[MAX_PLY];
+
+// Base late-move reduction by depth and move number, from log(depth) * log(moveNumber)
+int lmrTable[MAX_SEARCH_DEPTH + 1][64];
+
+struct LateMoveReductionInitializer {
+    LateMoveReductionInitializer() {
+        for (int depth = 0; depth <= MAX_SEARCH_DEPTH; depth++) {
+            for (int moveNumber = 0; moveNumber < 64; moveNumber++) {
+                lmrTable[depth][moveNumber] = depth == 0 || moveNumber == 0 ? 0 :
+                    (int)(1.0 + std::log((double)depth) * std::log((double)moveNumber) / 1.5);
+            }
+        }
+    }
+} lateMoveReductionInitializer;
+
+// Forward pruning margins by remaining depth, in centipawns; only nodes up to PRUNING_DEPTH are pruned
+const int PRUNING_DEPTH = 8;
+
+struct PruningParameters {
+    int reverseFutilityMargin[PRUNING_DEPTH + 1];
+    int futilityMargin[PRUNING_DEPTH + 1];
+    int razorMargin[PRUNING_DEPTH + 1];
+    // Quiet moves searched before the rest are skipped, by [improving][depth]
+    int lateMoveCount[2][PRUNING_DEPTH + 1];
+};
+
+// Changed at runtime through SetPruningParameter; a margin of 0 turns that depth off
+PruningParameters pruningParameters = {
+    { 0, 90, 180, 270, 360, 450, 540, 630, 720 },
+    { 0, 150, 250, 350, 450, 550, 0, 0, 0 },
+    { 0, 300, 500, 0, 0, 0, 0, 0, 0 },
+    { { 0, 3, 5, 8, 12, 17, 23, 30, 38 },
+      { 0, 5, 8, 13, 20, 28, 37, 48, 60 } }
+};
+std::mutex pruningParametersMutex;
+
+// What Negamax reads: each search thread copies pruningParameters when its search starts, so a
+// SetPruningParameter call during a search only takes effect from the next one
+thread_local PruningParameters searchPruning = {};
+
+void SnapshotPruningParameters() {
+    std::lock_guard<std::mutex> lock(pruningParametersMutex);
+    searchPruning = pruningParameters;
+}
+
+// Null-move cutoffs from this depth up are confirmed by a reduced search without the null move
+const int NULL_MOVE_VERIFY_DEPTH = 8;
+thread_local Move killerMoves[MAX_PLY][2] = {};
+
+// Quiet-move history, kept per thread. Gravity updates hold every entry within +-HISTORY_MAX
+const int HISTORY_MAX = 16384;
+const int HISTORY_PIECES = 12;
+thread_local int butterflyHistory[2][64][64] = {};
+thread_local Move counterMoves[HISTORY_PIECES][64] = {};
+// Indexed by the move 1 or 2 plies back and the current move, each as (piece, to square)
+thread_local std::vector<int16_t> continuationHistory(HISTORY_PIECES * 64 * HISTORY_PIECES * 64);
+
+thread_local UndoRecord undoStack[MAX_PLY];
+thread_local int undoDepth = 0;
+
+std::chrono::high_resolution_clock::time_point searchStartTime;
+
+// Lazy SMP: helper threads search the same root and share results only through the TT
+const int MAX_SEARCH_THREADS = 256;
+int searchThreadCount = 1;
+std::atomic<bool> stopHelpers(false);
+thread_local int searchThreadIndex = 0;
 
 // --- Start of Chess Personalities Settings --- \\
 
@@ -86,51 +340,545 @@ enum ChessPersonality {
     DYNAMIC = 4
 };
 
-ChessPersonality currentPersonality = STANDARD;
+// Chosen by SetEnginePersonality; each thread works on its own copy because the search switches it temporarily
+ChessPersonality selectedPersonality = STANDARD;
+thread_local ChessPersonality currentPersonality = STANDARD;
 // --- End of Chess Personalities Settings --- \\
 
-std::unordered_map<uint64_t, int> evaluationCache;
-const size_t MAX_EVAL_CACHE_SIZE = 500000;
+// Each slot packs the upper 32 key bits with the score, so one relaxed atomic load or store is always consistent
+const size_t EVAL_CACHE_SIZE = 1 << 20;
+std::atomic<uint64_t> evaluationCache[EVAL_CACHE_SIZE];
+
+// --- Start of Bitboard Helpers --- \\
+
+inline Bitboard SquareBit(int square) {
+    return 1ULL << square;
+}
+
+inline int PopCount(Bitboard b) {
+#if defined(_MSC_VER) && defined(_WIN64)
+    return (int)__popcnt64(b);
+#elif defined(_MSC_VER)
+    return (int)(__popcnt((unsigned int)b) + __popcnt((unsigned int)(b >> 32)));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+inline int LSB(Bitboard b) {
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)b)) return (int)index;
+    _BitScanForward(&index, (unsigned long)(b >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int PopLSB(Bitboard& b) {
+    int square = LSB(b);
+    b &= b - 1;
+    return square;
+}
+
+inline int SideIndex(bool isWhite) {
+    return isWhite ? 0 : 1;
+}
+
+inline bool IsWhitePiece(char piece) {
+    return piece >= 'A' && piece <= 'Z';
+}
+
+inline int PieceTypeOf(char piece) {
+    switch (piece) {
+        case 'P': case 'p': return PAWN;
+        case 'N': case 'n': return KNIGHT;
+        case 'B': case 'b': return BISHOP;
+        case 'R': case 'r': return ROOK;
+        case 'Q': case 'q': return QUEEN;
+        case 'K': case 'k': return KING;
+        default: return NO_PIECE_TYPE;
+    }
+}
+
+inline char PieceChar(int pieceType, bool isWhite) {
+    return (isWhite ? "PNBRQK" : "pnbrqk")[pieceType];
+}
+
+inline Bitboard Pieces(const BoardPosition& position, bool isWhite, int pieceType) {
+    return position.pieceBitboards[SideIndex(isWhite)][pieceType];
+}
+
+inline Bitboard SidePieces(const BoardPosition& position, bool isWhite) {
+    return position.colorBitboards[SideIndex(isWhite)];
+}
+
+// NO_PIECE_TYPE keeps an all-zero row so an unrecognised piece char hashes to nothing
+uint64_t zobristPieces[2][NO_PIECE_TYPE + 1][64];
+uint64_t zobristCastling[16];
+uint64_t zobristEnPassant[8];
+uint64_t zobristSide;
+uint64_t zobristPersonality[DYNAMIC + 1][2];
+// The opening terms of EvaluateBoard look at fullMoveNumber, which the position hash leaves out
+const int EVAL_MOVE_BUCKETS = 7;
+uint64_t zobristMoveBucket[EVAL_MOVE_BUCKETS];
+
+inline uint64_t PieceKey(int square, char piece) {
+    return zobristPieces[SideIndex(IsWhitePiece(piece))][PieceTypeOf(piece)][square];
+}
+
+// Four bits of piece count per side and piece type
+inline uint64_t MaterialKeyUnit(int side, int type) {
+    return 1ULL << (4 * (side * 6 + type));
+}
+
+inline int MaterialCount(uint64_t materialKey, bool isWhite, int type) {
+    return (int)((materialKey >> (4 * (SideIndex(isWhite) * 6 + type))) & 0xF);
+}
+
+inline int CastlingRights(const BoardPosition& position) {
+    return position.whiteCanCastleKingside | (position.whiteCanCastleQueenside << 1) |
+           (position.blackCanCastleKingside << 2) | (position.blackCanCastleQueenside << 3);
+}
+
+// Everything in the key besides piece placement: castling rights, en passant file and side to move
+inline uint64_t StateKey(const BoardPosition& position) {
+    uint64_t key = zobristCastling[CastlingRights(position)];
+    if (position.enPassantTargetSquare >= 0) {
+        key ^= zobristEnPassant[position.enPassantTargetSquare % 8];
+    }
+    if (position.whiteToMove) {
+        key ^= zobristSide;
+    }
+    return key;
+}
+
+inline void PutPiece(BoardPosition& position, int square, char piece) {
+    Bitboard bit = SquareBit(square);
+    int side = SideIndex(IsWhitePiece(piece));
+    position.boardState[square] = piece;
+    position.hash ^= PieceKey(square, piece);
+    if (PieceTypeOf(piece) == PAWN) position.pawnHash ^= PieceKey(square, piece);
+    position.materialKey += MaterialKeyUnit(side, PieceTypeOf(piece));
+    position.pieceBitboards[side][PieceTypeOf(piece)] |= bit;
+    position.colorBitboards[side] |= bit;
+    position.occupied |= bit;
+}
+
+inline void RemovePiece(BoardPosition& position, int square) {
+    char piece = position.boardState[square];
+    if (piece == ' ') return;
+
+    Bitboard bit = SquareBit(square);
+    int side = SideIndex(IsWhitePiece(piece));
+    position.boardState[square] = ' ';
+    position.hash ^= PieceKey(square, piece);
+    if (PieceTypeOf(piece) == PAWN) position.pawnHash ^= PieceKey(square, piece);
+    position.materialKey -= MaterialKeyUnit(side, PieceTypeOf(piece));
+    position.pieceBitboards[side][PieceTypeOf(piece)] &= ~bit;
+    position.colorBitboards[side] &= ~bit;
+    position.occupied &= ~bit;
+}
+
+void SetupBoard(BoardPosition& position, const std::string& boardState) {
+    for (int side = 0; side < 2; side++) {
+        for (int type = 0; type < 6; type++) {
+            position.pieceBitboards[side][type] = 0;
+        }
+        position.colorBitboards[side] = 0;
+    }
+    position.occupied = 0;
+    position.hash = 0;
+    position.pawnHash = 0;
+    position.materialKey = 0;
+
+    for (int i = 0; i < 64; i++) {
+        position.boardState[i] = ' ';
+        if (i < (int)boardState.size() && PieceTypeOf(boardState[i]) != NO_PIECE_TYPE) {
+            PutPiece(position, i, boardState[i]);
+        }
+    }
+}
+
+Bitboard fileMasks[8];
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard pawnAttacks[2][64];
+Bitboard passedPawnMasks[2][64];
+Bitboard betweenMasks[64][64];
+Bitboard lineMasks[64][64];
+
+const int BISHOP_DIRECTIONS[4][2] = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
+const int ROOK_DIRECTIONS[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+
+Bitboard SlidingAttacks(int square, Bitboard occupied, const int directions[4][2]) {
+    Bitboard attacks = 0;
+    int row = square / 8;
+    int col = square % 8;
+
+    for (int d = 0; d < 4; d++) {
+        int r = row + directions[d][0];
+        int c = col + directions[d][1];
+
+        while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+            Bitboard bit = SquareBit(r * 8 + c);
+            attacks |= bit;
+            if (occupied & bit) break;
+            r += directions[d][0];
+            c += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    int shift;
+};
+
+Magic bishopMagics[64];
+Magic rookMagics[64];
+Bitboard bishopAttackTable[5248];
+Bitboard rookAttackTable[102400];
+
+// Chosen once at load; the slider tables are filled in PEXT order when set
+bool usePext = false;
+
+inline unsigned MagicIndex(const Magic& magic, Bitboard occupied) {
+    return (unsigned)(((occupied & magic.mask) * magic.magic) >> magic.shift);
+}
+
+#if PEXT_SUPPORTED
+#if !defined(_MSC_VER)
+__attribute__((target("bmi2")))
+#endif
+inline unsigned PextIndex(const Magic& magic, Bitboard occupied) {
+    return (unsigned)_pext_u64(occupied, magic.mask);
+}
+#endif
+
+inline unsigned SliderIndex(const Magic& magic, Bitboard occupied) {
+#if PEXT_SUPPORTED
+    if (usePext) {
+        return PextIndex(magic, occupied);
+    }
+#endif
+    return MagicIndex(magic, occupied);
+}
+
+inline Bitboard BishopAttacks(int square, Bitboard occupied) {
+    const Magic& magic = bishopMagics[square];
+    return magic.attacks[SliderIndex(magic, occupied)];
+}
+
+inline Bitboard RookAttacks(int square, Bitboard occupied) {
+    const Magic& magic = rookMagics[square];
+    return magic.attacks[SliderIndex(magic, occupied)];
+}
+
+void Cpuid(int registers[4], int leaf, int subleaf) {
+#if PEXT_SUPPORTED && defined(_MSC_VER)
+    __cpuidex(registers, leaf, subleaf);
+#elif PEXT_SUPPORTED
+    unsigned int eax, ebx, ecx, edx;
+    __cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+    registers[0] = (int)eax;
+    registers[1] = (int)ebx;
+    registers[2] = (int)ecx;
+    registers[3] = (int)edx;
+#else
+    registers[0] = registers[1] = registers[2] = registers[3] = 0;
+#endif
+}
+
+bool HasFastPext() {
+#if PEXT_SUPPORTED
+    int registers[4];
+    Cpuid(registers, 0, 0);
+    int maxLeaf = registers[0];
+    bool isAmd = registers[1] == 0x68747541; // "Auth"enticAMD
+
+    if (maxLeaf < 7) return false;
+
+    Cpuid(registers, 7, 0);
+    bool hasBmi2 = (registers[1] >> 8) & 1;
+    if (!hasBmi2) return false;
+
+    // PEXT is microcoded and very slow on AMD before Zen 3 (family 19h)
+    if (isAmd) {
+        Cpuid(registers, 1, 0);
+        int family = (registers[0] >> 8) & 0xF;
+        if (family == 0xF) {
+            family += (registers[0] >> 20) & 0xFF;
+        }
+        if (family < 0x19) return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline Bitboard QueenAttacks(int square, Bitboard occupied) {
+    return BishopAttacks(square, occupied) | RookAttacks(square, occupied);
+}
+
+Bitboard StepAttacks(int square, const int steps[][2], int stepCount) {
+    Bitboard attacks = 0;
+    int row = square / 8;
+    int col = square % 8;
+
+    for (int i = 0; i < stepCount; i++) {
+        int r = row + steps[i][0];
+        int c = col + steps[i][1];
+        if (r >= 0 && r < 8 && c >= 0 && c < 8) {
+            attacks |= SquareBit(r * 8 + c);
+        }
+    }
+    return attacks;
+}
+
+uint64_t MagicRandom(uint64_t& seed) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 2685821657736338717ULL;
+}
+
+// PRNG seeds per board row, picked so the magic search finishes quickly at load
+const uint64_t BISHOP_MAGIC_SEEDS[8] = { 4116, 1421, 2450, 1513, 1053, 4126, 383, 1586 };
+const uint64_t ROOK_MAGIC_SEEDS[8] = { 13533, 13685, 5026, 4180, 12558, 17012, 12538, 16417 };
+
+void InitMagics(Magic magics[64], Bitboard* table, const int directions[4][2], const uint64_t seeds[8]) {
+    static Bitboard occupancies[4096];
+    static Bitboard reference[4096];
+    static int epoch[4096];
+    int attempt = 0;
+    uint64_t seed = 0;
+    Bitboard* attacks = table;
+
+    for (int i = 0; i < 4096; i++) {
+        epoch[i] = 0;
+    }
+
+    for (int square = 0; square < 64; square++) {
+        Magic& magic = magics[square];
+        int row = square / 8;
+        int file = square % 8;
+        if (file == 0) {
+            seed = seeds[row];
+        }
+        Bitboard edges = ((0xFFULL | 0xFF00000000000000ULL) & ~(0xFFULL << (row * 8))) |
+                         ((fileMasks[0] | fileMasks[7]) & ~fileMasks[file]);
+
+        magic.mask = SlidingAttacks(square, 0, directions) & ~edges;
+        magic.shift = 64 - PopCount(magic.mask);
+        magic.attacks = attacks;
+
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancies[size] = subset;
+            reference[size] = SlidingAttacks(square, subset, directions);
+            size++;
+            subset = (subset - magic.mask) & magic.mask;
+        } while (subset);
+        attacks += size;
+
+        if (usePext) {
+            for (int i = 0; i < size; i++) {
+                magic.attacks[SliderIndex(magic, occupancies[i])] = reference[i];
+            }
+            continue;
+        }
+
+        for (int i = 0; i < size;) {
+            do {
+                magic.magic = MagicRandom(seed) & MagicRandom(seed) & MagicRandom(seed);
+            } while (PopCount((magic.mask * magic.magic) >> 56) < 6);
+
+            attempt++;
+            for (i = 0; i < size; i++) {
+                unsigned index = MagicIndex(magic, occupancies[i]);
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    magic.attacks[index] = reference[i];
+                } else if (magic.attacks[index] != reference[i]) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void InitZobristKeys() {
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int side = 0; side < 2; side++) {
+        for (int type = 0; type < 6; type++) {
+            for (int square = 0; square < 64; square++) {
+                zobristPieces[side][type][square] = MagicRandom(seed);
+            }
+        }
+    }
+    for (int rights = 0; rights < 16; rights++) {
+        zobristCastling[rights] = MagicRandom(seed);
+    }
+    for (int file = 0; file < 8; file++) {
+        zobristEnPassant[file] = MagicRandom(seed);
+    }
+    zobristSide = MagicRandom(seed);
+    for (int personality = STANDARD; personality <= DYNAMIC; personality++) {
+        zobristPersonality[personality][0] = MagicRandom(seed);
+        zobristPersonality[personality][1] = MagicRandom(seed);
+    }
+    for (int bucket = 0; bucket < EVAL_MOVE_BUCKETS; bucket++) {
+        zobristMoveBucket[bucket] = MagicRandom(seed);
+    }
+}
+
+uint64_t ComputeZobristKey(const BoardPosition& position) {
+    uint64_t key = StateKey(position);
+    Bitboard pieces = position.occupied;
+    while (pieces) {
+        int square = PopLSB(pieces);
+        key ^= PieceKey(square, position.boardState[square]);
+    }
+    return key;
+}
+
+void InitAttackTables() {
+    const int knightSteps[8][2] = {
+        {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+        {1, -2}, {1, 2}, {2, -1}, {2, 1}
+    };
+    const int kingSteps[8][2] = {
+        {-1, -1}, {-1, 0}, {-1, 1},
+        {0, -1},           {0, 1},
+        {1, -1},  {1, 0},  {1, 1}
+    };
+    const int whitePawnSteps[2][2] = { {-1, -1}, {-1, 1} };
+    const int blackPawnSteps[2][2] = { {1, -1}, {1, 1} };
+
+    for (int file = 0; file < 8; file++) {
+        fileMasks[file] = 0;
+        for (int row = 0; row < 8; row++) {
+            fileMasks[file] |= SquareBit(row * 8 + file);
+        }
+    }
+
+    usePext = HasFastPext();
+    InitMagics(bishopMagics, bishopAttackTable, BISHOP_DIRECTIONS, BISHOP_MAGIC_SEEDS);
+    InitMagics(rookMagics, rookAttackTable, ROOK_DIRECTIONS, ROOK_MAGIC_SEEDS);
+
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            betweenMasks[from][to] = 0;
+            lineMasks[from][to] = 0;
+            if (BishopAttacks(from, 0) & SquareBit(to)) {
+                betweenMasks[from][to] = BishopAttacks(from, SquareBit(to)) & BishopAttacks(to, SquareBit(from));
+                lineMasks[from][to] = (BishopAttacks(from, 0) & BishopAttacks(to, 0)) | SquareBit(from) | SquareBit(to);
+            } else if (RookAttacks(from, 0) & SquareBit(to)) {
+                betweenMasks[from][to] = RookAttacks(from, SquareBit(to)) & RookAttacks(to, SquareBit(from));
+                lineMasks[from][to] = (RookAttacks(from, 0) & RookAttacks(to, 0)) | SquareBit(from) | SquareBit(to);
+            }
+        }
+    }
+
+    for (int square = 0; square < 64; square++) {
+        knightAttacks[square] = StepAttacks(square, knightSteps, 8);
+        kingAttacks[square] = StepAttacks(square, kingSteps, 8);
+        pawnAttacks[0][square] = StepAttacks(square, whitePawnSteps, 2);
+        pawnAttacks[1][square] = StepAttacks(square, blackPawnSteps, 2);
+
+        int row = square / 8;
+        int file = square % 8;
+        passedPawnMasks[0][square] = 0;
+        passedPawnMasks[1][square] = 0;
+        for (int f = customMax(0, file - 1); f <= customMin(7, file + 1); f++) {
+            for (int r = row - 1; r >= 0; r--) {
+                passedPawnMasks[0][square] |= SquareBit(r * 8 + f);
+            }
+            for (int r = row + 1; r < 8; r++) {
+                passedPawnMasks[1][square] |= SquareBit(r * 8 + f);
+            }
+        }
+    }
+}
+
+struct AttackTablesInitializer {
+    AttackTablesInitializer() {
+        InitZobristKeys();
+        InitAttackTables();
+    }
+} attackTablesInitializer;
+
+// --- End of Bitboard Helpers --- \\
 
 // ---------------------------- Start of Function declarations ---------------------------- \\
 
 void StoreKillerMove(const Move& move, int ply);
 bool IsKiller(const Move& move, int ply);
-uint64_t GetZobristKey(const std::string& boardState);
-void StoreTranspositionTable(const std::string& boardState, int depth,
+int QuietHistoryScore(const BoardPosition& position, const Move& move);
+void UpdateQuietHistory(const BoardPosition& position, const Move& bestMove, const Move* failedQuiets, int failedCount, int depth);
+Move CounterMoveFor();
+void AgeHistoryTables();
+uint64_t GetZobristKey(const BoardPosition& position);
+void StoreTranspositionTable(const BoardPosition& position, int depth,
 	int flag, int score, const Move& bestMove);
-bool ProbeTranspositionTable(const std::string& boardState, int depth,
+bool ProbeTranspositionTable(const BoardPosition& position, int depth,
 	int& alpha, int& beta, int& score, Move& bestMove);
-MoveTreeNode* BuildMoveTree(const BoardPosition& position, int depth, bool isWhiteTurn);
-void ExpandNode(MoveTreeNode* node, int depth, bool isWhiteTurn, const BoardPosition& position);
-void OrderMoves(std::vector<Move>& moves, int ply, const std::string& boardState, const Move& ttMove = Move());
+int BuildMoveTree(MoveTreeArena& arena, BoardPosition& position, int depth, bool isWhiteTurn);
+void ExpandNode(MoveTreeArena& arena, int node, int depth, bool isWhiteTurn, BoardPosition& position);
+int CaptureScore(const BoardPosition& position, const Move& move);
+bool IsWinningCapture(const BoardPosition& position, const Move& move, bool isWhite);
 int GetPieceValue(char piece);
-int Quiescence(const BoardPosition& position, int alpha, int beta, bool maximizingPlayer, int maxDepth);
-bool IsGoodCapture(const BoardPosition& position, const Move& move);
+int Quiescence(BoardPosition& position, int alpha, int beta, bool maximizingPlayer, int maxDepth);
+bool IsGoodCapture(BoardPosition& position, const Move& move);
 bool IsSquareAttacked(const BoardPosition& position, int square, bool byWhite);
+Bitboard AttackersTo(const BoardPosition& position, int square, bool byWhite);
+Bitboard AttackersTo(const BoardPosition& position, int square, bool byWhite, Bitboard occupied);
 int GetCheapestAttackerValue(const BoardPosition& position, int square, bool byWhite);
 bool HasMaterialThreat(const BoardPosition& position, bool forWhite);
-int MinimaxOnTree(MoveTreeNode* node, int depth, int alpha, int beta, bool maximizingPlayer, bool allowNullMove = true);
-bool IsCapture(const std::string& boardState, const Move& move);
-bool IsCheck(const BoardPosition& position, const Move& move);
-bool IsDraw(const std::string& boardState);
+int Negamax(BoardPosition& position, int depth, int alpha, int beta, bool maximizingPlayer, bool pvNode, bool allowNullMove = true);
+bool IsCapture(const BoardPosition& position, const Move& move);
+bool IsCheck(BoardPosition& position, const Move& move);
+bool IsDraw(const BoardPosition& position);
+const MaterialEntry& ProbeMaterialTable(const BoardPosition& position);
 BoardPosition ApplyMove(const BoardPosition& position, const Move& move);
+void MakeMove(BoardPosition& position, const Move& move);
+void UnmakeMove(BoardPosition& position);
+void MakeNullMove(BoardPosition& position);
+bool HasNonPawnMaterial(const BoardPosition& position, bool isWhite);
 bool IsKingInCheck(const BoardPosition& position, bool isWhiteKing);
-std::vector<Move> GenerateMoves(const BoardPosition& position, bool isWhite, bool skipCastlingCheck = false);
-int Minimax(const BoardPosition& position, int depth, int alpha, int beta, bool maximizingPlayer);
-bool IsValidMove(const std::string& boardState, int row, int col, bool isWhite);
-void AddMove(const std::string& boardState, int startPos, int endPos, char piece,
-    std::vector<Move>& moves);
-void GeneratePawnMoves(const std::string& boardState, int row, int col, int pos,
-    bool isWhite, std::vector<Move>& moves, int enPassantCol = -1);
-void GenerateKnightMoves(const std::string& boardState, int row, int col, int pos,
-    bool isWhite, std::vector<Move>& moves);
-void GenerateBishopMoves(const std::string& boardState, int row, int col, int pos,
-    bool isWhite, std::vector<Move>& moves, char actualPiece = '\0');
-void GenerateRookMoves(const std::string& boardState, int row, int col, int pos,
-    bool isWhite, std::vector<Move>& moves, char actualPiece = '\0');
-void GenerateKingMoves(const std::string& boardState, int row, int col, int pos,
-    bool isWhite, std::vector<Move>& moves, const BoardPosition& position, bool skipCastlingCheck = false);
+void GenerateMoves(const BoardPosition& position, bool isWhite, MoveList& moves, bool skipCastlingCheck = false);
+void GenerateLegalMoves(const BoardPosition& position, bool isWhite, MoveList& moves, MoveGenType genType = ALL_MOVES);
+bool IsLegalMove(const BoardPosition& position, const Move& move, bool isWhite);
+Bitboard PinnedPieces(const BoardPosition& position, bool isWhite, int kingSquare);
+bool IsLegalEnPassant(const BoardPosition& position, const Move& move, bool isWhite, int kingSquare);
+int CountMoves(const BoardPosition& position, bool isWhite);
+Bitboard PawnTargets(const BoardPosition& position, int pos, bool isWhite);
+bool CanCaptureEnPassant(const BoardPosition& position, int pos, bool isWhite);
+int Minimax(BoardPosition& position, int depth, int alpha, int beta, bool maximizingPlayer);
+void AddMoves(int startPos, Bitboard targets, MoveList& moves);
+void GeneratePawnMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves);
+void GenerateKnightMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves);
+void GenerateBishopMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves);
+void GenerateRookMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves);
+void GenerateKingMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves, bool skipCastlingCheck = false);
+void GenerateCastlingMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves);
 int EvaluateBoard(const BoardPosition& position, int searchDepth = 0);
 BoardPosition ParseMoveHistory(const std::string& moveHistory);
 BoardPosition ApplyAlgebraicMove(const BoardPosition& position, const std::string& algebraicMove);
@@ -138,175 +886,385 @@ int AlgebraicToIndex(const std::string& algebraic);
 std::string ConvertToAlgebraic(const Move& move, const BoardPosition& position);
 std::string IndexToAlgebraic(int index);
 Move AlgebraicToInternalMove(const std::string& algebraicMove, const BoardPosition& position);
-void PrintBoard(const std::string& boardState);
+void PrintBoard(const BoardPosition& position);
 int EvaluateOpeningPrinciples(const BoardPosition& position);
 int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position, 
-                               const std::vector<Move>* preCalculatedMoves,
+                               const MoveList* preCalculatedMoves,
                                bool fullCalculation = true);
-bool IsMoveSafe(const BoardPosition& position, const Move& move);
+bool IsMoveSafe(BoardPosition& position, const Move& move, std::string* diagnostic = nullptr);
 bool IsValidMoveNotation(const Move& move); 
-bool IsTacticalBlunder(const BoardPosition& position, const Move& move);
+bool IsTacticalBlunder(BoardPosition& position, const Move& move, std::string* diagnostic = nullptr);
+void ReportDiagnostic(const std::string& message, std::string* diagnostic);
+int CountProtectedPieces(BoardPosition& position, const Move& move);
 int EvaluatePawnStructure(const BoardPosition& position, bool forWhite);
 // ---------------------------- End of Function declarations ---------------------------- \\
 
 void StoreKillerMove(const Move& move, int ply) {
-    if (!(killerMoves[ply][0].notation == move.notation)) {
+    if (killerMoves[ply][0] != move) {
         killerMoves[ply][1] = killerMoves[ply][0];
         killerMoves[ply][0] = move;
     }
 }
 
 bool IsKiller(const Move& move, int ply) {
-    return (killerMoves[ply][0].notation == move.notation) || 
-           (killerMoves[ply][1].notation == move.notation);
+    return killerMoves[ply][0] == move || killerMoves[ply][1] == move;
 }
 
-uint64_t GetZobristKey(const std::string& boardState) {
-    uint64_t key = 0;
-    for (size_t i = 0; i < boardState.size(); i++) {
-        if (boardState[i] != ' ') {
-            key ^= ((uint64_t)boardState[i] << (i % 8)) + i;
+inline int HistoryPieceIndex(char piece) {
+    return SideIndex(IsWhitePiece(piece)) * 6 + PieceTypeOf(piece);
+}
+
+// The move made pliesBack plies ago in this search, or nullptr past the root or across a null move
+inline const UndoRecord* PreviousMove(int pliesBack) {
+    if (undoDepth < pliesBack) return nullptr;
+    const UndoRecord* record = &undoStack[undoDepth - pliesBack];
+    return record->move.IsNull() ? nullptr : record;
+}
+
+inline int16_t* ContinuationEntry(const UndoRecord* previous, char piece, int to) {
+    int previousIndex = HistoryPieceIndex(previous->movedPiece) * 64 + previous->move.To();
+    return &continuationHistory[(previousIndex * HISTORY_PIECES + HistoryPieceIndex(piece)) * 64 + to];
+}
+
+inline int HistoryBonus(int depth) {
+    return customMin(32 * depth * depth + 64 * depth, 2000);
+}
+
+// Moves the entry toward +-HISTORY_MAX by bonus, more slowly the closer it already is
+template <typename T>
+inline void ApplyGravity(T& entry, int bonus) {
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+int QuietHistoryScore(const BoardPosition& position, const Move& move) {
+    char piece = position.boardState[move.From()];
+    int score = butterflyHistory[SideIndex(IsWhitePiece(piece))][move.From()][move.To()];
+    for (int pliesBack = 1; pliesBack <= 2; pliesBack++) {
+        if (const UndoRecord* previous = PreviousMove(pliesBack)) {
+            score += *ContinuationEntry(previous, piece, move.To());
         }
     }
-    return key;
+    return score;
 }
 
-const int TT_SIZE = 1 << 20;
-std::vector<TTEntry> transpositionTable(TT_SIZE);
+void UpdateQuietHistory(const BoardPosition& position, const Move& bestMove, const Move* failedQuiets, int failedCount, int depth) {
+    int bonus = HistoryBonus(depth);
+
+    auto update = [&](const Move& move, int amount) {
+        char piece = position.boardState[move.From()];
+        ApplyGravity(butterflyHistory[SideIndex(IsWhitePiece(piece))][move.From()][move.To()], amount);
+        for (int pliesBack = 1; pliesBack <= 2; pliesBack++) {
+            if (const UndoRecord* previous = PreviousMove(pliesBack)) {
+                ApplyGravity(*ContinuationEntry(previous, piece, move.To()), amount);
+            }
+        }
+    };
+
+    update(bestMove, bonus);
+    for (int i = 0; i < failedCount; i++) {
+        update(failedQuiets[i], -bonus);
+    }
 
-void StoreTranspositionTable(const std::string& boardState, int depth, 
+    if (const UndoRecord* previous = PreviousMove(1)) {
+        counterMoves[HistoryPieceIndex(previous->movedPiece)][previous->move.To()] = bestMove;
+    }
+}
+
+Move CounterMoveFor() {
+    const UndoRecord* previous = PreviousMove(1);
+    return previous ? counterMoves[HistoryPieceIndex(previous->movedPiece)][previous->move.To()] : Move();
+}
+
+// Butterfly history is halved between searches so recent games dominate. The 1.2MB continuation table is
+// left to its gravity updates, since rewriting it would cost every search as much as a fresh helper thread did
+void AgeHistoryTables() {
+    int* butterfly = &butterflyHistory[0][0][0];
+    for (int i = 0; i < 2 * 64 * 64; i++) {
+        butterfly[i] /= 2;
+    }
+}
+
+// Salting the cache keys per game lets NewGame invalidate the TT and eval cache without touching them
+uint64_t gameKeySalt = 0;
+uint64_t gameSaltSeed = 0x9E3779B97F4A7C15ULL;
+
+uint64_t GetZobristKey(const BoardPosition& position) {
+    return position.hash ^ gameKeySalt;
+}
+
+const int DEFAULT_HASH_SIZE_MB = 16;
+TTBucket* transpositionTable = nullptr;
+size_t ttBucketCount = 0;
+uint8_t ttGeneration = 1;
+// Same-key stores within this many plies of the existing depth still overwrite it
+const int TT_DEPTH_SLACK = 2;
+
+// Tables of 2MB or more are aligned to 2MB so Linux can back them with transparent huge pages
+void* AllocateTable(size_t bytes) {
+    const size_t hugePageSize = 2 * 1024 * 1024;
+#if defined(_WIN32)
+    return _aligned_malloc(bytes, 64);
+#else
+    void* memory = nullptr;
+    if (bytes >= hugePageSize && bytes % hugePageSize == 0) {
+        memory = std::aligned_alloc(hugePageSize, bytes);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (memory) {
+            madvise(memory, bytes, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    if (!memory) {
+        memory = std::aligned_alloc(64, bytes);
+    }
+    return memory;
+#endif
+}
+
+void FreeTable(void* memory) {
+#if defined(_WIN32)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+inline TTBucket& TTBucketFor(uint64_t key) {
+    return transpositionTable[key & (ttBucketCount - 1)];
+}
+
+bool ResizeTranspositionTable(size_t sizeMB) {
+    size_t buckets = 1;
+    while (buckets * 2 * sizeof(TTBucket) <= sizeMB * 1024 * 1024) {
+        buckets *= 2;
+    }
+
+    TTBucket* table = (TTBucket*)AllocateTable(buckets * sizeof(TTBucket));
+    if (!table) {
+        return false;
+    }
+
+    std::uninitialized_fill_n(table, buckets, TTBucket());
+    FreeTable(transpositionTable);
+    transpositionTable = table;
+    ttBucketCount = buckets;
+    return true;
+}
+
+struct TranspositionTableInitializer {
+    TranspositionTableInitializer() {
+        ResizeTranspositionTable(DEFAULT_HASH_SIZE_MB);
+    }
+} transpositionTableInitializer;
+
+// Lockless hashing: key32 is stored XORed with the packed payload, so an entry torn by a concurrent write fails the key check
+inline uint32_t TTPayloadCheck(const TTEntry& entry) {
+    uint64_t payload = (uint32_t)entry.score | ((uint64_t)entry.bestMove.data << 32) |
+                       ((uint64_t)(uint8_t)entry.depth << 48) | ((uint64_t)entry.genBound << 56);
+    return (uint32_t)payload ^ (uint32_t)(payload >> 32);
+}
+
+inline uint32_t TTEntryKey(const TTEntry& entry) {
+    return entry.key32 ^ TTPayloadCheck(entry);
+}
+
+// Entries from older searches lose 8 plies of depth per generation when picking a slot to overwrite
+inline int TTReplaceValue(const TTEntry& entry) {
+    int age = (ttGeneration - (entry.genBound >> 2)) & 0x3F;
+    return entry.depth - 8 * age;
+}
+
+void StoreTranspositionTable(const BoardPosition& position, int depth, 
                            int flag, int score, const Move& bestMove) {
-    uint64_t key = GetZobristKey(boardState);
-    int index = key % TT_SIZE;
-    
-    transpositionTable[index] = {key, depth, flag, score, bestMove};
+    uint64_t key = GetZobristKey(position);
+    uint32_t key32 = (uint32_t)(key >> 32);
+    TTBucket& bucket = TTBucketFor(key);
+
+    TTEntry* replace = &bucket.entries[0];
+    for (TTEntry& entry : bucket.entries) {
+        if (TTEntryKey(entry) == key32) {
+            // A shallow bound from this search must not evict a deeper result for the same position
+            bool sameGeneration = (entry.genBound >> 2) == ttGeneration;
+            if (flag != TT_EXACT && sameGeneration && depth < entry.depth - TT_DEPTH_SLACK) {
+                return;
+            }
+            replace = &entry;
+            break;
+        }
+        if (TTReplaceValue(entry) < TTReplaceValue(*replace)) {
+            replace = &entry;
+        }
+    }
+
+    TTEntry stored;
+    stored.score = score;
+    stored.bestMove = bestMove;
+    stored.depth = (int8_t)customMax(-128, customMin(depth, 127));
+    stored.genBound = (uint8_t)((ttGeneration << 2) | flag);
+
+    TTEntry previous = *replace;
+    if (stored.bestMove.IsNull() && TTEntryKey(previous) == key32) {
+        stored.bestMove = previous.bestMove;
+    }
+    stored.key32 = key32 ^ TTPayloadCheck(stored);
+    *replace = stored;
 }
 
-bool ProbeTranspositionTable(const std::string& boardState, int depth, 
+bool ProbeTranspositionTable(const BoardPosition& position, int depth, 
                            int& alpha, int& beta, int& score, Move& bestMove) {
-    uint64_t key = GetZobristKey(boardState);
-    int index = key % TT_SIZE;
-    
-    if (transpositionTable[index].zobristKey == key) {
-        TTEntry& entry = transpositionTable[index];
-        
+    uint64_t key = GetZobristKey(position);
+    uint32_t key32 = (uint32_t)(key >> 32);
+    TTBucket& bucket = TTBucketFor(key);
+
+    for (const TTEntry& slot : bucket.entries) {
+        TTEntry entry = slot;
+        if (TTEntryKey(entry) != key32) continue;
+
+        bestMove = entry.bestMove;
         if (entry.depth >= depth) {
-            bestMove = entry.bestMove;
-            
-            if (entry.flag == TT_EXACT) {
+            int flag = entry.genBound & 0x3;
+            if (flag == TT_EXACT) {
                 score = entry.score;
                 return true;
-            } else if (entry.flag == TT_ALPHA && entry.score <= alpha) {
+            } else if (flag == TT_ALPHA && entry.score <= alpha) {
                 score = alpha;
                 return true;
-            } else if (entry.flag == TT_BETA && entry.score >= beta) {
+            } else if (flag == TT_BETA && entry.score >= beta) {
                 score = beta;
                 return true;
             }
         }
+        return false;
     }
     return false;
 }
 
 
 
-MoveTreeNode* BuildMoveTree(const BoardPosition& position, int depth, bool isWhiteTurn) {
-    MoveTreeNode* root = new MoveTreeNode(position.boardState);
+// Debug only: materializes the full move tree for PrintMoveTree, the search itself keeps no tree
+int BuildMoveTree(MoveTreeArena& arena, BoardPosition& position, int depth, bool isWhiteTurn) {
+    arena.Reset();
+    int root = arena.Allocate(Move(), -1);
+    ExpandNode(arena, root, depth, isWhiteTurn, position);
+    return root;
+}
 
-    if (depth <= 0) {
-        return root;
-    }
+void ExpandNode(MoveTreeArena& arena, int node, int depth, bool isWhiteTurn, BoardPosition& position) {
+    if (depth <= 0) return;
 
-    std::vector<Move> possibleMoves = GenerateMoves(position, isWhiteTurn);
+    MoveList possibleMoves;
+    GenerateLegalMoves(position, isWhiteTurn, possibleMoves);
 
+    // Siblings are allocated back to back before any of them is expanded
+    int firstChild = arena.Size();
     for (const Move& move : possibleMoves) {
-        BoardPosition newPosition = ApplyMove(position, move);
-
-        MoveTreeNode* childNode = new MoveTreeNode(newPosition.boardState, move, root);
+        arena.Allocate(move, node);
+    }
+    arena[node].firstChild = firstChild;
+    arena[node].childCount = possibleMoves.size();
 
-        if (depth > 1) {
-            MoveTreeNode* responseTree = BuildMoveTree(newPosition, depth - 1, !isWhiteTurn);
-            for (MoveTreeNode* grandchild : responseTree->children) {
-                childNode->children.push_back(grandchild);
-            }
-            delete responseTree;
+    if (depth > 1) {
+        for (int i = 0; i < possibleMoves.size(); i++) {
+            MakeMove(position, possibleMoves[i]);
+            ExpandNode(arena, firstChild + i, depth - 1, !isWhiteTurn, position);
+            UnmakeMove(position);
         }
-
-        root->children.push_back(childNode);
     }
+}
 
-    return root;
+int CaptureScore(const BoardPosition& position, const Move& move) {
+    int victimValue = move.IsEnPassant() ? 1 : GetPieceValue(position.boardState[move.To()]);
+    int score = victimValue * 100 - GetPieceValue(position.boardState[move.From()]);
+    if (move.IsPromotion()) {
+        score += GetPieceValue(PieceChar(move.Promotion(), true)) * 100;
+    }
+    return score;
 }
 
-void ExpandNode(MoveTreeNode* node, int depth, bool isWhiteTurn, const BoardPosition& position) {
-    if (depth <= 0) return;
+bool IsWinningCapture(const BoardPosition& position, const Move& move, bool isWhite) {
+    if (move.IsPromotion() || move.IsEnPassant()) return true;
 
-    std::vector<Move> possibleMoves = GenerateMoves(position, isWhiteTurn);
+    int victimValue = GetPieceValue(position.boardState[move.To()]);
+    int attackerValue = GetPieceValue(position.boardState[move.From()]);
+    return victimValue >= attackerValue || !IsSquareAttacked(position, move.To(), !isWhite);
+}
 
-    for (const Move& move : possibleMoves) {
-        BoardPosition newPosition = position;
-        newPosition = ApplyMove(position, move);
-        MoveTreeNode* childNode = new MoveTreeNode(newPosition.boardState, move, node);
+MovePicker::MovePicker(const BoardPosition& pos, bool white, int pickerPly, const Move& tt) :
+    position(pos), isWhite(white), ply(pickerPly), ttMove(tt), counterMove(CounterMoveFor()) {
+}
 
-        if (depth > 1) {
-            ExpandNode(childNode, depth - 1, !isWhiteTurn, newPosition);
-        }
+Move MovePicker::Next() {
+    while (true) {
+        switch (stage) {
+            case TT_MOVE_STAGE:
+                stage = GOOD_CAPTURES_STAGE;
+                if (IsLegalMove(position, ttMove, isWhite)) {
+                    return ttMove;
+                }
+                break;
 
-        node->children.push_back(childNode);
-    }
-}
+            case GOOD_CAPTURES_STAGE:
+                // Captures are only generated once the TT move has failed to cut off
+                if (!generated) {
+                    generated = true;
+                    GenerateLegalMoves(position, isWhite, moves, CAPTURES);
+                    for (int i = 0; i < moves.size(); i++) {
+                        moves.scores[i] = CaptureScore(position, moves[i]);
+                    }
+                }
+                while (index < moves.size()) {
+                    Move move = moves.PickBest(index++);
+                    if (move == ttMove) continue;
+                    if (!IsWinningCapture(position, move, isWhite)) {
+                        badCaptures.push_back(move);
+                        continue;
+                    }
+                    return move;
+                }
+                stage = KILLERS_STAGE;
+                index = 0;
+                break;
 
-void OrderMoves(std::vector<Move>& moves, int ply, const std::string& boardState, const Move& ttMove) {
-    std::vector<std::pair<int, Move>> scoredMoves;
-    
-    for (const Move& move : moves) {
-        int score = 0;
-        
-        if (!ttMove.notation.empty() && move.notation == ttMove.notation) {
-            score = 20000;
-        }
-        else if (move.notation.length() >= 5) {
-            int endPos = std::stoi(move.notation.substr(3, 2));
-            char victim = boardState[endPos];
-            
-            if (victim != ' ' || move.isEnPassant) {
-                BoardPosition tempPos;
-                tempPos.boardState = boardState;
-                
-                if (IsGoodCapture(tempPos, move)) {
-                    int captureScore = 10000;
-                    
-                    if (victim != ' ') {
-                        char attacker = move.notation[0];
-                        captureScore += GetPieceValue(victim) * 100 - GetPieceValue(attacker);
-                    } else if (move.isEnPassant) {
-                        captureScore += 100;
+            case KILLERS_STAGE:
+                // Two killers, then the countermove to the opponent's last move
+                while (ply >= 0 && ply < MAX_PLY && index < 3) {
+                    Move refutation = index < 2 ? killerMoves[ply][index] : counterMove;
+                    index++;
+                    if (refutation.IsNull() || refutation == ttMove || (index == 3 && IsKiller(refutation, ply))) continue;
+                    if (!refutation.IsPromotion() && !IsCapture(position, refutation) &&
+                        IsLegalMove(position, refutation, isWhite)) {
+                        return refutation;
                     }
-                    
-                    score = captureScore;
-                } else {
-                    score = -100;
                 }
-            }
-        }
-        else if (IsKiller(move, ply)) {
-            score = 9000;
-        }
-        else {
-            score = 0;
+                stage = QUIETS_STAGE;
+                moves.clear();
+                GenerateLegalMoves(position, isWhite, moves, QUIETS);
+                for (int i = 0; i < moves.size(); i++) {
+                    moves.scores[i] = QuietHistoryScore(position, moves[i]);
+                }
+                index = 0;
+                break;
+
+            case QUIETS_STAGE:
+                while (index < moves.size()) {
+                    Move move = moves.PickBest(index++);
+                    if (move == ttMove || move == counterMove || (ply >= 0 && ply < MAX_PLY && IsKiller(move, ply))) continue;
+                    return move;
+                }
+                stage = BAD_CAPTURES_STAGE;
+                index = 0;
+                break;
+
+            case BAD_CAPTURES_STAGE:
+                if (index < badCaptures.size()) {
+                    return badCaptures[index++];
+                }
+                stage = PICKER_DONE;
+                break;
+
+            default:
+                return Move();
         }
-        
-        scoredMoves.push_back({score, move});
-    }
-    
-    std::sort(scoredMoves.begin(), scoredMoves.end(), 
-        [](const auto& a, const auto& b) {
-            return a.first > b.first;
-        });
-    
-    moves.clear();
-    for (const auto& [score, move] : scoredMoves) {
-        moves.push_back(move);
     }
 }
 
@@ -322,95 +1280,82 @@ int GetPieceValue(char piece) {
     }
 }
 
-int Quiescence(const BoardPosition& position, int alpha, int beta, bool maximizingPlayer, int maxDepth) {
+int Quiescence(BoardPosition& position, int alpha, int beta, bool maximizingPlayer, int maxDepth) {
     ChessPersonality savedPersonality = currentPersonality;
     if (maxDepth <= 3) currentPersonality = STANDARD;
 
+    // Negamax scores are from the point of view of the side to move
     int standPat = EvaluateBoard(position, -maxDepth); 
+    if (!maximizingPlayer) standPat = -standPat;
 
     currentPersonality = savedPersonality;
     
-
-    if (maximizingPlayer) {
-        if (standPat >= beta) return beta;
-        if (standPat > alpha) alpha = standPat;
-    } else {
-        if (standPat <= alpha) return alpha;
-        if (standPat < beta) beta = standPat;
-    }
+    if (standPat >= beta) return beta;
+    if (standPat > alpha) alpha = standPat;
     
     if (maxDepth <= 0) return standPat;
     
-    std::vector<Move> allMoves = GenerateMoves(position, maximizingPlayer);
-    std::vector<std::pair<int, Move>> scoredCaptures;
+    MoveList allMoves;
+    GenerateLegalMoves(position, maximizingPlayer, allMoves, CAPTURES);
+    MoveList scoredCaptures;
     
     for (const Move& move : allMoves) {
-        int endPos = std::stoi(move.notation.substr(move.notation.length() - 2));
-        char target = position.boardState[endPos];
+        char target = position.boardState[move.To()];
         
-        if (target != ' ' || move.isEnPassant) {
+        if (target != ' ' || move.IsEnPassant()) {
             int score = 0;
             if (target != ' ') {
                 int victimValue = GetPieceValue(target) * 10;
-                int attackerValue = GetPieceValue(move.notation[0]);
+                int attackerValue = GetPieceValue(position.boardState[move.From()]);
                 score = victimValue - attackerValue;
-            } else if (move.isEnPassant) {
+            } else if (move.IsEnPassant()) {
                 score = 10;
             }
-            scoredCaptures.push_back({score, move});
+            scoredCaptures.push_back(move, score);
         }
     }
     
-    std::sort(scoredCaptures.begin(), scoredCaptures.end(),
-        [](const auto& a, const auto& b) { return a.first > b.first; });
-    
-    for (const auto& [score, move] : scoredCaptures) {
-        BoardPosition newPosition = ApplyMove(position, move);
-        int evalScore = -Quiescence(newPosition, -beta, -alpha, !maximizingPlayer, maxDepth - 1);
+    for (int i = 0; i < scoredCaptures.size(); i++) {
+        Move move = scoredCaptures.PickBest(i);
+        MakeMove(position, move);
+        int evalScore = -Quiescence(position, -beta, -alpha, !maximizingPlayer, maxDepth - 1);
+        UnmakeMove(position);
         
-        if (maximizingPlayer) {
-            if (evalScore >= beta) return beta;
-            if (evalScore > alpha) alpha = evalScore;
-        } else {
-            if (evalScore <= alpha) return alpha;
-            if (evalScore < beta) beta = evalScore;
-        }
+        if (evalScore >= beta) return beta;
+        if (evalScore > alpha) alpha = evalScore;
     }
     
-    return maximizingPlayer ? alpha : beta;
+    return alpha;
 }
 
-bool IsGoodCapture(const BoardPosition& position, const Move& move) {
-    if (move.notation.length() < 5) return false;
-    
-    int startPos = std::stoi(move.notation.substr(1, 2));
-    int endPos = std::stoi(move.notation.substr(3, 2));
+bool IsGoodCapture(BoardPosition& position, const Move& move) {
+    int startPos = move.From();
+    int endPos = move.To();
     
     char attacker = position.boardState[startPos];
     char victim = position.boardState[endPos];
     
-    if (victim == ' ' && !move.isEnPassant) return false;
+    if (victim == ' ' && !move.IsEnPassant()) return false;
     
     int attackerValue = GetPieceValue(attacker);
-    int victimValue = move.isEnPassant ? 1 : GetPieceValue(victim);
+    int victimValue = move.IsEnPassant() ? 1 : GetPieceValue(victim);
     
     bool isGoodValueCapture = (victimValue > attackerValue);
     bool hasCompensation = false;
+    bool isWhite = position.whiteToMove;
     
-    BoardPosition afterCapture = ApplyMove(position, move);
-    std::vector<Move> responses = GenerateMoves(afterCapture, !position.whiteToMove);
+    MakeMove(position, move);
+    MoveList responses;
+    GenerateMoves(position, !isWhite, responses);
+    UnmakeMove(position);
     
     for (const Move& response : responses) {
-        if (response.notation.length() >= 5) {
-            int responseTargetPos = std::stoi(response.notation.substr(3, 2));
+        if (response.To() == endPos) {
+            char recapturer = position.boardState[response.From()];
+            int recapturerValue = GetPieceValue(recapturer);
             
-            if (responseTargetPos == endPos) {
-                char recapturer = position.boardState[std::stoi(response.notation.substr(1, 2))];
-                int recapturerValue = GetPieceValue(recapturer);
-                
-                if (recapturerValue <= attackerValue) {
-                    return false;
-                }
+            if (recapturerValue <= attackerValue) {
+                return false;
             }
         }
     }
@@ -419,12 +1364,9 @@ bool IsGoodCapture(const BoardPosition& position, const Move& move) {
         bool isPionDefended = false;
         
         for (const Move& response : responses) {
-            if (response.notation.length() >= 5) {
-                int responseTargetPos = std::stoi(response.notation.substr(3, 2));
-                if (responseTargetPos == endPos) {
-                    isPionDefended = true;
-                    break;
-                }
+            if (response.To() == endPos) {
+                isPionDefended = true;
+                break;
             }
         }
         
@@ -437,23 +1379,33 @@ bool IsGoodCapture(const BoardPosition& position, const Move& move) {
     if (!isGoodValueCapture) {
         bool hasCompensation = false;
         
+        Bitboard wasDefended = 0;
+        Bitboard enemyPieces = SidePieces(position, !isWhite);
+        while (enemyPieces) {
+            int i = PopLSB(enemyPieces);
+            if (IsSquareAttacked(position, i, !isWhite)) {
+                wasDefended |= SquareBit(i);
+            }
+        }
+        
+        MakeMove(position, move);
         for (int i = 0; i < 64; i++) {
             if (i == endPos) continue;
             
-            char targetPiece = afterCapture.boardState[i];
-            bool isEnemyPiece = (position.whiteToMove && islower(targetPiece) && targetPiece != ' ') ||
-                               (!position.whiteToMove && isupper(targetPiece) && targetPiece != ' ');
+            char targetPiece = position.boardState[i];
+            bool isEnemyPiece = (isWhite && islower(targetPiece) && targetPiece != ' ') ||
+                               (!isWhite && isupper(targetPiece) && targetPiece != ' ');
             
             if (isEnemyPiece && GetPieceValue(targetPiece) >= attackerValue) {
-                bool wasDefended = IsSquareAttacked(position, i, !position.whiteToMove);
-                bool isStillDefended = IsSquareAttacked(afterCapture, i, !position.whiteToMove);
+                bool isStillDefended = IsSquareAttacked(position, i, !isWhite);
                 
-                if (wasDefended && !isStillDefended) {
+                if ((wasDefended & SquareBit(i)) && !isStillDefended) {
                     hasCompensation = true;
                     break;
                 }
             }
         }
+        UnmakeMove(position);
         
         if (!hasCompensation) {
             return false;
@@ -481,172 +1433,44 @@ bool IsGoodCapture(const BoardPosition& position, const Move& move) {
 }
 
 bool IsSquareAttacked(const BoardPosition& position, int square, bool byWhite) {
-    for (int i = 0; i < 64; i++) {
-        char attacker = position.boardState[i];
-        if (attacker == ' ') continue;
-        
-        bool isWhitePiece = isupper(attacker);
-        if (byWhite != isWhitePiece) continue;
-        
-        switch (tolower(attacker)) {
-            case 'p': {
-                int rank = i / 8;
-                int file = i % 8;
-                int targetRank = square / 8;
-                int targetFile = square % 8;
-                
-                if (isWhitePiece) {
-                    if (rank - 1 == targetRank && 
-                        (file - 1 == targetFile || file + 1 == targetFile)) {
-                        return true;
-                    }
-                } else {
-                    if (rank + 1 == targetRank && 
-                        (file - 1 == targetFile || file + 1 == targetFile)) {
-                        return true;
-                    }
-                }
-                break;
-            }
-            case 'n': {
-                int rank = i / 8;
-                int file = i % 8;
-                int targetRank = square / 8;
-                int targetFile = square % 8;
-                
-                int rankDiff = std::abs(rank - targetRank);
-                int fileDiff = std::abs(file - targetFile);
-                
-                if ((rankDiff == 1 && fileDiff == 2) || (rankDiff == 2 && fileDiff == 1)) {
-                    return true;
-                }
-                break;
-            }
-            case 'b': {
-                int rank = i / 8;
-                int file = i % 8;
-                int targetRank = square / 8;
-                int targetFile = square % 8;
-                
-                int rankDiff = targetRank - rank;
-                int fileDiff = targetFile - file;
-                
-                if (std::abs(rankDiff) == std::abs(fileDiff)) {
-                    int rankStep = (rankDiff > 0) ? 1 : ((rankDiff < 0) ? -1 : 0);
-                    int fileStep = (fileDiff > 0) ? 1 : ((fileDiff < 0) ? -1 : 0);
-                    
-                    bool blocked = false;
-                    for (int r = rank + rankStep, f = file + fileStep; 
-                         r != targetRank || f != targetFile; 
-                         r += rankStep, f += fileStep) {
-                        if (position.boardState[r*8+f] != ' ') {
-                            blocked = true;
-                            break;
-                        }
-                    }
-                    if (!blocked) return true;
-                }
-                break;
-            }
-            case 'r': {
-                int rank = i / 8;
-                int file = i % 8;
-                int targetRank = square / 8;
-                int targetFile = square % 8;
-                
-                if (rank == targetRank || file == targetFile) {
-                    int rankStep = (rank == targetRank) ? 0 : ((targetRank > rank) ? 1 : -1);
-                    int fileStep = (file == targetFile) ? 0 : ((targetFile > file) ? 1 : -1);
-                    
-                    bool blocked = false;
-                    for (int r = rank + rankStep, f = file + fileStep; 
-                         r != targetRank || f != targetFile; 
-                         r += rankStep, f += fileStep) {
-                        if (position.boardState[r*8+f] != ' ') {
-                            blocked = true;
-                            break;
-                        }
-                    }
-                    if (!blocked) return true;
-                }
-                break;
-            }
-            case 'q': {
-                int rank = i / 8;
-                int file = i % 8;
-                int targetRank = square / 8;
-                int targetFile = square % 8;
-                
-                int rankDiff = targetRank - rank;
-                int fileDiff = targetFile - file;
-                
-                if (rank == targetRank || file == targetFile || std::abs(rankDiff) == std::abs(fileDiff)) {
-                    int rankStep = (rank == targetRank) ? 0 : ((targetRank > rank) ? 1 : -1);
-                    int fileStep = (file == targetFile) ? 0 : ((targetFile > file) ? 1 : -1);
-                    
-                    bool blocked = false;
-                    for (int r = rank + rankStep, f = file + fileStep; 
-                         r != targetRank || f != targetFile; 
-                         r += rankStep, f += fileStep) {
-                        if (position.boardState[r*8+f] != ' ') {
-                            blocked = true;
-                            break;
-                        }
-                    }
-                    if (!blocked) return true;
-                }
-                break;
-            }
-            case 'k': {
-                int rank = i / 8;
-                int file = i % 8;
-                int targetRank = square / 8;
-                int targetFile = square % 8;
-                
-                int rankDiff = std::abs(rank - targetRank);
-                int fileDiff = std::abs(file - targetFile);
-                
-                if (rankDiff <= 1 && fileDiff <= 1) {
-                    return true;
-                }
-                break;
-            }
-        }
-    }
-    return false;
+    return AttackersTo(position, square, byWhite) != 0;
+}
+
+Bitboard AttackersTo(const BoardPosition& position, int square, bool byWhite) {
+    return AttackersTo(position, square, byWhite, position.occupied);
+}
+
+Bitboard AttackersTo(const BoardPosition& position, int square, bool byWhite, Bitboard occupied) {
+    Bitboard diagonalSliders = Pieces(position, byWhite, BISHOP) | Pieces(position, byWhite, QUEEN);
+    Bitboard straightSliders = Pieces(position, byWhite, ROOK) | Pieces(position, byWhite, QUEEN);
+
+    return (pawnAttacks[SideIndex(!byWhite)][square] & Pieces(position, byWhite, PAWN)) |
+           (knightAttacks[square] & Pieces(position, byWhite, KNIGHT)) |
+           (kingAttacks[square] & Pieces(position, byWhite, KING)) |
+           (BishopAttacks(square, occupied) & diagonalSliders) |
+           (RookAttacks(square, occupied) & straightSliders);
 }
 
 int GetCheapestAttackerValue(const BoardPosition& position, int square, bool byWhite) {
-    int cheapestValue = 10000; 
-    
-    BoardPosition tempPos = position;
-    tempPos.whiteToMove = byWhite;
-    std::vector<Move> opponentMoves = GenerateMoves(tempPos, byWhite);
-    
-    for (const Move& move : opponentMoves) {
-        if (move.notation.length() >= 5) {
-            int endPos = std::stoi(move.notation.substr(3, 2));
-            if (endPos == square) { 
-                int startPos = std::stoi(move.notation.substr(1, 2));
-                char attacker = position.boardState[startPos];
-                int attackerValue = GetPieceValue(attacker);
-                
-                if (attackerValue < cheapestValue) {
-                    cheapestValue = attackerValue;
-                }
-            }
+    static const int attackerOrder[6] = { KING, PAWN, KNIGHT, BISHOP, ROOK, QUEEN };
+    Bitboard attackers = AttackersTo(position, square, byWhite);
+    if (!attackers) return 0;
+
+    for (int pieceType : attackerOrder) {
+        Bitboard typeAttackers = attackers & Pieces(position, byWhite, pieceType);
+        if (typeAttackers) {
+            return GetPieceValue(position.boardState[LSB(typeAttackers)]);
         }
     }
-    
-    return (cheapestValue < 10000) ? cheapestValue : 0;
+    return 0;
 }
 
 bool HasMaterialThreat(const BoardPosition& position, bool forWhite) {
-    std::vector<Move> opponentMoves = GenerateMoves(position, !forWhite);
+    MoveList opponentMoves;
+    GenerateMoves(position, !forWhite, opponentMoves);
     
     for (const Move& move : opponentMoves) {
-        int endPos = std::stoi(move.notation.substr(move.notation.length() - 2));
-        char target = position.boardState[endPos];
+        char target = position.boardState[move.To()];
         
         if ((forWhite && islower(target) && tolower(target) != 'p') ||
             (!forWhite && isupper(target) && toupper(target) != 'P')) {
@@ -657,95 +1481,127 @@ bool HasMaterialThreat(const BoardPosition& position, bool forWhite) {
     return false;
 }
 
-int MinimaxOnTree(MoveTreeNode* node, int depth, int alpha, int beta, bool maximizingPlayer, bool allowNullMove) {
-    static int nodeCount = 0;
+// pvNode is set by the caller for the first move and full-window re-searches of PV nodes; every other node is searched with a null window
+int Negamax(BoardPosition& position, int depth, int alpha, int beta, bool maximizingPlayer, bool pvNode, bool allowNullMove) {
+    if (searchThreadIndex != 0 && stopHelpers.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("Helper search stopped");
+    }
+
+    thread_local int nodeCount = 0;
     if (++nodeCount % 1000 == 0) {
-        static auto startTime = std::chrono::high_resolution_clock::now();
         auto currentTime = std::chrono::high_resolution_clock::now();
-        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count();
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - searchStartTime).count();
         if (elapsedMs > 10000) {
             throw std::runtime_error("Time limit exceeded");
         }
     }
     
-    if (node->isEvaluated) {
-        return node->evaluation;
-    }
-
     Move ttMove;
     int ttScore;
-    if (ProbeTranspositionTable(node->boardState, depth, alpha, beta, ttScore, ttMove)) {
+    if (ProbeTranspositionTable(position, depth, alpha, beta, ttScore, ttMove)) {
         return ttScore;
     }
 
     if (depth <= 0) {
-        BoardPosition tempPosition;
-        tempPosition.boardState = node->boardState;
         ChessPersonality savedPersonality = currentPersonality;
         if (depth < -2) currentPersonality = STANDARD;
         
-        node->evaluation = Quiescence(tempPosition, alpha, beta, maximizingPlayer, 3);
+        int eval = Quiescence(position, alpha, beta, maximizingPlayer, 3);
         
         currentPersonality = savedPersonality;
-        node->isEvaluated = true;
         
-        int flag = (node->evaluation <= alpha) ? TT_ALPHA : 
-                  ((node->evaluation >= beta) ? TT_BETA : TT_EXACT);
-        StoreTranspositionTable(node->boardState, depth, flag, node->evaluation, Move());
-        return node->evaluation;
+        int flag = (eval <= alpha) ? TT_ALPHA : 
+                  ((eval >= beta) ? TT_BETA : TT_EXACT);
+        StoreTranspositionTable(position, depth, flag, eval, Move());
+        return eval;
     }
 
-    if (node->children.empty()) {
-        BoardPosition tempPosition;
-        tempPosition.boardState = node->boardState;
-        ExpandNode(node, 1, maximizingPlayer, tempPosition);
-        
-        if (node->children.empty()) {
-            bool isInCheck = IsKingInCheck(tempPosition, maximizingPlayer);
-            node->evaluation = isInCheck ? 
-                (maximizingPlayer ? -100000 + depth * 100 : 100000 - depth * 100) : 0;
-            node->isEvaluated = true;
-            return node->evaluation;
-        }
+    bool isInCheck = IsKingInCheck(position, maximizingPlayer);
+    int staticEval = NO_EVAL;
+    if (!isInCheck) {
+        staticEval = EvaluateBoard(position, depth);
+        if (!maximizingPlayer) staticEval = -staticEval;
     }
+    staticEvalStack[undoDepth] = staticEval;
+    // Improving: static eval is up on this side's previous turn, so cutoffs here are likelier
+    bool improving = !isInCheck && undoDepth >= 2 && staticEvalStack[undoDepth - 2] != NO_EVAL &&
+                     staticEval > staticEvalStack[undoDepth - 2];
+
+    bool canPrune = !pvNode && !isInCheck && depth <= PRUNING_DEPTH && beta > -90000 && beta < 90000;
 
-    std::vector<Move> moves;
-    for (const auto& child : node->children) {
-        moves.push_back(child->move);
+    // Reverse futility: far enough above beta that no reply is expected to bring it back
+    int rfpMargin = searchPruning.reverseFutilityMargin[customMin(depth, PRUNING_DEPTH)];
+    if (canPrune && rfpMargin > 0 && staticEval - rfpMargin + (improving ? 50 : 0) >= beta) {
+        return staticEval;
     }
-    OrderMoves(moves, depth, node->boardState, ttMove);
 
-    int bestValue = -2147483647;
-    Move bestMove;
-    int nodeFlag = TT_ALPHA;
+    // Razoring: so far below alpha that only captures can save it, which Quiescence checks directly
+    int razorMargin = searchPruning.razorMargin[customMin(depth, PRUNING_DEPTH)];
+    if (canPrune && razorMargin > 0 && staticEval + razorMargin < alpha) {
+        int razorScore = Quiescence(position, alpha - 1, alpha, maximizingPlayer, 3);
+        if (razorScore < alpha) return razorScore;
+    }
 
-    BoardPosition currentPosition;
-    currentPosition.boardState = node->boardState;
-    currentPosition.whiteToMove = maximizingPlayer;
+    // Null move: if passing still fails high, a real move will too. Pawn-only sides are left out because of zugzwang
+    if (allowNullMove && !pvNode && !isInCheck && depth >= 3 && beta > -90000 && beta < 90000 &&
+        HasNonPawnMaterial(position, maximizingPlayer)) {
+        if (staticEval >= beta) {
+            int R = 3 + depth / 6 + customMin((staticEval - beta) / 200, 3);
+
+            MakeNullMove(position);
+            int nullScore = -Negamax(position, depth - 1 - R, -beta, -beta + 1, !maximizingPlayer, false, false);
+            UnmakeMove(position);
+
+            if (nullScore >= beta) {
+                if (nullScore >= 90000) nullScore = beta;
+                if (depth < NULL_MOVE_VERIFY_DEPTH) return nullScore;
+
+                int verifyScore = Negamax(position, depth - R, beta - 1, beta, maximizingPlayer, false, false);
+                if (verifyScore >= beta) return nullScore;
+            }
+        }
+    }
 
-    for (int i = 0; i < node->children.size(); i++) {
-        MoveTreeNode* childNode = node->children[i];
-        BoardPosition tempPosition;
-        tempPosition.boardState = childNode->boardState;
+    MovePicker picker(position, maximizingPlayer, depth, ttMove);
+    int moveCount = 0;
+
+    int bestValue = -INFINITE_SCORE;
+    Move bestMove;
+    int nodeFlag = TT_ALPHA;
+    Move failedQuiets[64];
+    int failedQuietCount = 0;
+    bool ttMoveIsCapture = IsCapture(position, ttMove);
+    // Set only once a move has gone through a real recursive search, not the blunder shortcut
+    bool hasSearchedMove = false;
+
+    for (Move move = picker.Next(); !move.IsNull(); move = picker.Next()) {
+        int i = moveCount++;
+        bool isCapture = IsCapture(position, move);
+
+        // Frontier quiets: late ones and ones that cannot lift the static eval to alpha are skipped
+        if (canPrune && !isCapture && !move.IsPromotion() && hasSearchedMove && bestValue > -90000) {
+            int lmpCount = searchPruning.lateMoveCount[improving][depth];
+            int futilityMargin = searchPruning.futilityMargin[depth];
+            bool lateMove = lmpCount > 0 && i >= lmpCount;
+            bool futile = futilityMargin > 0 && staticEval + futilityMargin <= alpha;
+            if ((lateMove || futile) && !IsCheck(position, move)) {
+                continue;
+            }
+        }
         
-        if (!IsCapture(tempPosition.boardState, childNode->move) && 
-            !IsMoveSafe(currentPosition, childNode->move)) {
+        if (!isCapture && !IsMoveSafe(position, move)) {
             
-            int blunderScore = maximizingPlayer ? -5000 : 5000;
             
-            if (depth >= 3) {
-                std::string moveText = ConvertToAlgebraic(childNode->move, currentPosition);
+            if (depth >= 3 && searchThreadIndex == 0) {
+                std::string moveText = ConvertToAlgebraic(move, position);
                 std::cout << "Detected blunder: " << moveText << " at depth " << depth << std::endl;
             }
             
-            childNode->evaluation = blunderScore;
-            childNode->isEvaluated = true;
-            
-            int eval = -blunderScore;
+            int eval = -5000;
             
             if (eval > bestValue) {
                 bestValue = eval;
-                bestMove = childNode->move;
+                bestMove = move;
                 
                 if (bestValue > alpha) {
                     alpha = bestValue;
@@ -758,235 +1614,526 @@ int MinimaxOnTree(MoveTreeNode* node, int depth, int alpha, int beta, bool maxim
                 }
             }
             
+            // A quiet that hangs material is exactly the one history should learn to order last
+            if (failedQuietCount < 64) {
+                failedQuiets[failedQuietCount++] = move;
+            }
             continue;
         }
         
         int eval;
-        if (i >= 2 && depth >= 3 && !IsCapture(tempPosition.boardState, childNode->move) && !IsCheck(tempPosition, childNode->move)) {
-            int R = 1 + customMin(depth / 2, 3) + customMin(i / 5, 3);
-            eval = -MinimaxOnTree(childNode, depth - 1 - R, -beta, -alpha, !maximizingPlayer, false);
+        int R = 0;
+        if (i >= (pvNode ? 2 : 1) && depth >= 3 && !isCapture) {
+            R = lmrTable[customMin(depth, MAX_SEARCH_DEPTH)][customMin(i, 63)];
+            if (pvNode) R--;
+            if (!improving) R++;
+            if (isInCheck || IsCheck(position, move)) R--;
+            if (ttMoveIsCapture) R++;
+            // Quiets with a good history are reduced less, ones that keep failing more
+            R -= QuietHistoryScore(position, move) / 8192;
+            R = customMax(0, customMin(R, depth - 2));
+        }
+
+        MakeMove(position, move);
+        if (i == 0) {
+            eval = -Negamax(position, depth - 1, -beta, -alpha, !maximizingPlayer, pvNode);
+        } else {
+            // PVS: later moves only need to prove they cannot beat alpha, re-searched when they do
+            eval = -Negamax(position, depth - 1 - R, -alpha - 1, -alpha, !maximizingPlayer, false);
             
+            if (eval > alpha && R > 0) {
+                eval = -Negamax(position, depth - 1, -alpha - 1, -alpha, !maximizingPlayer, false);
+            }
             if (eval > alpha && eval < beta) {
-                eval = -MinimaxOnTree(childNode, depth - 1, -beta, -alpha, !maximizingPlayer, false);
+                eval = -Negamax(position, depth - 1, -beta, -alpha, !maximizingPlayer, true);
             }
-        } else {
-            eval = -MinimaxOnTree(childNode, depth - 1, -beta, -alpha, !maximizingPlayer, false);
         }
+        UnmakeMove(position);
+        hasSearchedMove = true;
         
         if (eval > bestValue) {
             bestValue = eval;
-            bestMove = childNode->move;
+            bestMove = move;
             
             if (bestValue > alpha) {
                 alpha = bestValue;
                 nodeFlag = TT_EXACT;
                 
-                if (!IsCapture(tempPosition.boardState, childNode->move)) {
-                    StoreKillerMove(childNode->move, depth);
+                if (!isCapture) {
+                    StoreKillerMove(move, depth);
                 }
                 
                 if (alpha >= beta) {
                     nodeFlag = TT_BETA;
+                    if (!isCapture) {
+                        UpdateQuietHistory(position, move, failedQuiets, failedQuietCount, depth);
+                    }
                     break;
                 }
             }
         }
+
+        if (!isCapture && failedQuietCount < 64) {
+            failedQuiets[failedQuietCount++] = move;
+        }
+    }
+
+    if (moveCount == 0) {
+        return isInCheck ? -MATE_SCORE - depth * 100 : 0;
     }
     
-    node->evaluation = bestValue;
-    node->isEvaluated = true;
-    StoreTranspositionTable(node->boardState, depth, nodeFlag, bestValue, bestMove);
+    StoreTranspositionTable(position, depth, nodeFlag, bestValue, bestMove);
     return bestValue;
 }
 
-bool IsCapture(const std::string& boardState, const Move& move) {
-    if (move.notation.empty() || move.notation.length() < 3) 
+bool IsCapture(const BoardPosition& position, const Move& move) {
+    if (move.IsNull())
         return false;
-        
-    int endPos = std::stoi(move.notation.substr(move.notation.length() - 2));
-    return boardState[endPos] != ' ' || move.isEnPassant;
+
+    return position.boardState[move.To()] != ' ' || move.IsEnPassant();
 }
 
-bool IsCheck(const BoardPosition& position, const Move& move) {
-    BoardPosition newPosition = ApplyMove(position, move);
+bool IsCheck(BoardPosition& position, const Move& move) {
+    bool isWhitePiece = IsWhitePiece(position.boardState[move.From()]);
 
-    char piece = move.notation[0];
-    bool isWhitePiece = isupper(piece);
+    MakeMove(position, move);
+    bool givesCheck = IsKingInCheck(position, !isWhitePiece);
+    UnmakeMove(position);
 
-    return IsKingInCheck(newPosition, !isWhitePiece);
+    return givesCheck;
 }
 
-bool IsDraw(const std::string& boardState) {
-    int whitePieceCount = 0;
-    int blackPieceCount = 0;
-    bool whiteHasMinor = false;
-    bool blackHasMinor = false;
-    
-    for (char piece : boardState) {
-        switch (piece) {
-            case 'P': case 'R': case 'Q':
-                whitePieceCount++;
-                break;
-            case 'p': case 'r': case 'q':
-                blackPieceCount++;
-                break;
-            case 'B': case 'N':
-                whitePieceCount++;
-                whiteHasMinor = true;
-                break;
-            case 'b': case 'n':
-                blackPieceCount++;
-                blackHasMinor = true;
-                break;
-        }
-    }
-    
-    if (whitePieceCount == 0 && blackPieceCount == 0)
-        return true;
-        
-    if ((whitePieceCount == 1 && whiteHasMinor && blackPieceCount == 0) ||
-        (blackPieceCount == 1 && blackHasMinor && whitePieceCount == 0))
-        return true;
-    
-    return false;
+bool IsDraw(const BoardPosition& position) {
+    return ProbeMaterialTable(position).isDrawn;
 }
 
-BoardPosition ApplyMove(const BoardPosition& position, const Move& move) {
-    if (move.notation.length() < 5) {
-        std::cerr << "Warning: Invalid move notation: '" << move.notation 
-                  << "', returning unchanged position" << std::endl;
-        return position;
-    }
-    BoardPosition newPosition = position;
-    const int BOARD_SIZE = 8;
-
-    char piece = move.notation[0];
-    std::string startPosStr = move.notation.substr(1, 2);
-    std::string endPosStr = move.notation.substr(3, 2);
-    int startPos = std::stoi(startPosStr);
-    int endPos = std::stoi(endPosStr);
-
-    newPosition.boardState[endPos] = newPosition.boardState[startPos];
-    newPosition.boardState[startPos] = ' ';
-
-    if (move.isEnPassant) {
-        newPosition.boardState[move.enPassantCapturePos] = ' ';
-    }
-
-    if (move.isCastling) {
-        if (move.isKingsideCastling) {
-            if (position.whiteToMove) {
-                newPosition.boardState[63] = ' ';
-                newPosition.boardState[61] = 'R';
-            } else {
-                newPosition.boardState[7] = ' ';
-                newPosition.boardState[5] = 'r';
-            }
+void MakeMove(BoardPosition& position, const Move& move) {
+    UndoRecord& undo = undoStack[undoDepth++];
+
+    int startPos = move.From();
+    int endPos = move.To();
+    int capturePos = move.IsEnPassant() ? move.EnPassantCapturePos() : endPos;
+
+    char piece = position.boardState[startPos];
+    bool isCapture = position.boardState[endPos] != ' ';
+
+    undo.move = move;
+    undo.capturedPiece = position.boardState[capturePos];
+    undo.whiteCanCastleKingside = position.whiteCanCastleKingside;
+    undo.whiteCanCastleQueenside = position.whiteCanCastleQueenside;
+    undo.blackCanCastleKingside = position.blackCanCastleKingside;
+    undo.blackCanCastleQueenside = position.blackCanCastleQueenside;
+    undo.enPassantTargetSquare = position.enPassantTargetSquare;
+    undo.halfMoveClock = position.halfMoveClock;
+    undo.hash = position.hash;
+    undo.pawnHash = position.pawnHash;
+    undo.movedPiece = piece;
+
+    position.hash ^= StateKey(position);
+    RemovePiece(position, capturePos);
+    RemovePiece(position, startPos);
+    if (piece != ' ') {
+        PutPiece(position, endPos, move.IsPromotion() ? PieceChar(move.Promotion(), IsWhitePiece(piece)) : piece);
+    }
+
+    if (move.IsCastling()) {
+        int rookFrom;
+        int rookTo;
+        if (move.IsKingsideCastling()) {
+            rookFrom = position.whiteToMove ? 63 : 7;
+            rookTo = position.whiteToMove ? 61 : 5;
         } else {
-            if (position.whiteToMove) {
-                newPosition.boardState[56] = ' ';
-                newPosition.boardState[59] = 'R';
-            } else {
-                newPosition.boardState[0] = ' ';
-                newPosition.boardState[3] = 'r';
-            }
+            rookFrom = position.whiteToMove ? 56 : 0;
+            rookTo = position.whiteToMove ? 59 : 3;
         }
+        RemovePiece(position, rookFrom);
+        PutPiece(position, rookTo, position.whiteToMove ? 'R' : 'r');
     }
 
     if (piece == 'K') {
-        newPosition.whiteCanCastleKingside = false;
-        newPosition.whiteCanCastleQueenside = false;
+        position.whiteCanCastleKingside = false;
+        position.whiteCanCastleQueenside = false;
     } else if (piece == 'k') {
-        newPosition.blackCanCastleKingside = false;
-        newPosition.blackCanCastleQueenside = false;
+        position.blackCanCastleKingside = false;
+        position.blackCanCastleQueenside = false;
     }
-    if (startPos == 0 || endPos == 0) newPosition.whiteCanCastleQueenside = false;
-    if (startPos == 7 || endPos == 7) newPosition.whiteCanCastleKingside = false;
-    if (startPos == 56 || endPos == 56) newPosition.blackCanCastleQueenside = false;
-    if (startPos == 63 || endPos == 63) newPosition.blackCanCastleKingside = false;
+    if (startPos == 56 || endPos == 56) position.whiteCanCastleQueenside = false;
+    if (startPos == 63 || endPos == 63) position.whiteCanCastleKingside = false;
+    if (startPos == 0 || endPos == 0) position.blackCanCastleQueenside = false;
+    if (startPos == 7 || endPos == 7) position.blackCanCastleKingside = false;
 
-    newPosition.enPassantTargetSquare = -1;
+    position.enPassantTargetSquare = -1;
     if ((piece == 'P' && startPos / 8 == 6 && endPos / 8 == 4) ||
         (piece == 'p' && startPos / 8 == 1 && endPos / 8 == 3)) {
-        newPosition.enPassantTargetSquare = (startPos + endPos) / 2;
+        position.enPassantTargetSquare = (startPos + endPos) / 2;
     }
 
-    if (tolower(piece) == 'p' || (position.boardState[endPos] != ' ')) {
-        newPosition.halfMoveClock = 0;
+    if (tolower(piece) == 'p' || isCapture) {
+        position.halfMoveClock = 0;
     } else {
-        newPosition.halfMoveClock++;
+        position.halfMoveClock++;
     }
 
     if (!position.whiteToMove) {
-        newPosition.fullMoveNumber++;
+        position.fullMoveNumber++;
+    }
+    position.whiteToMove = !position.whiteToMove;
+    position.hash ^= StateKey(position);
+}
+
+void UnmakeMove(BoardPosition& position) {
+    const UndoRecord& undo = undoStack[--undoDepth];
+    const Move& move = undo.move;
+
+    if (move.IsNull()) {
+        position.enPassantTargetSquare = undo.enPassantTargetSquare;
+        position.halfMoveClock = undo.halfMoveClock;
+        position.hash = undo.hash;
+        position.whiteToMove = !position.whiteToMove;
+        return;
+    }
+
+    int startPos = move.From();
+    int endPos = move.To();
+    bool moverIsWhite = !position.whiteToMove;
+
+    char piece = position.boardState[endPos];
+    if (move.IsPromotion() && piece != ' ') {
+        piece = PieceChar(PAWN, moverIsWhite);
+    }
+
+    RemovePiece(position, endPos);
+    if (piece != ' ') {
+        PutPiece(position, startPos, piece);
     }
-    newPosition.whiteToMove = !position.whiteToMove;
 
-    if (move.notation.length() > 5) {
-        char promotionPiece = move.notation[5];
-        if ((piece == 'P' && endPos / 8 == 0) || (piece == 'p' && endPos / 8 == 7)) {
-            newPosition.boardState[endPos] = promotionPiece;
+    if (move.IsCastling()) {
+        int rookFrom;
+        int rookTo;
+        if (move.IsKingsideCastling()) {
+            rookFrom = moverIsWhite ? 63 : 7;
+            rookTo = moverIsWhite ? 61 : 5;
+        } else {
+            rookFrom = moverIsWhite ? 56 : 0;
+            rookTo = moverIsWhite ? 59 : 3;
         }
+        RemovePiece(position, rookTo);
+        PutPiece(position, rookFrom, moverIsWhite ? 'R' : 'r');
+    }
+
+    if (undo.capturedPiece != ' ') {
+        PutPiece(position, move.IsEnPassant() ? move.EnPassantCapturePos() : endPos, undo.capturedPiece);
+    }
+
+    position.whiteCanCastleKingside = undo.whiteCanCastleKingside;
+    position.whiteCanCastleQueenside = undo.whiteCanCastleQueenside;
+    position.blackCanCastleKingside = undo.blackCanCastleKingside;
+    position.blackCanCastleQueenside = undo.blackCanCastleQueenside;
+    position.enPassantTargetSquare = undo.enPassantTargetSquare;
+    position.halfMoveClock = undo.halfMoveClock;
+    position.hash = undo.hash;
+    position.pawnHash = undo.pawnHash;
+
+    position.whiteToMove = moverIsWhite;
+    if (!moverIsWhite) {
+        position.fullMoveNumber--;
     }
+}
+
+// Passes the turn; undone by UnmakeMove like any other move
+void MakeNullMove(BoardPosition& position) {
+    UndoRecord& undo = undoStack[undoDepth++];
+
+    undo.move = Move();
+    undo.capturedPiece = ' ';
+    undo.enPassantTargetSquare = position.enPassantTargetSquare;
+    undo.halfMoveClock = position.halfMoveClock;
+    undo.hash = position.hash;
+    undo.pawnHash = position.pawnHash;
+    undo.movedPiece = ' ';
+
+    position.hash ^= StateKey(position);
+    position.enPassantTargetSquare = -1;
+    position.halfMoveClock++;
+    position.whiteToMove = !position.whiteToMove;
+    position.hash ^= StateKey(position);
+}
+
+bool HasNonPawnMaterial(const BoardPosition& position, bool isWhite) {
+    int side = SideIndex(isWhite);
+    return (position.pieceBitboards[side][KNIGHT] | position.pieceBitboards[side][BISHOP] |
+            position.pieceBitboards[side][ROOK] | position.pieceBitboards[side][QUEEN]) != 0;
+}
 
+BoardPosition ApplyMove(const BoardPosition& position, const Move& move) {
+    if (move.IsNull()) {
+        std::cerr << "Warning: Null move, returning unchanged position" << std::endl;
+        return position;
+    }
+    BoardPosition newPosition = position;
+    MakeMove(newPosition, move);
+    undoDepth--;
     return newPosition;
 }
 
 bool IsKingInCheck(const BoardPosition& position, bool isWhiteKing) {
-    const std::string& boardState = position.boardState;
-    char kingChar = isWhiteKing ? 'K' : 'k';
+    Bitboard king = Pieces(position, isWhiteKing, KING);
+    if (!king) return false;
 
-    int kingPos = -1;
-    for (size_t i = 0; i < boardState.size(); i++) {
-        if (boardState[i] == kingChar) {
-            kingPos = i;
-            break;
+    return IsSquareAttacked(position, LSB(king), !isWhiteKing);
+}
+
+void GenerateMoves(const BoardPosition& position, bool isWhite, MoveList& moves, bool skipCastlingCheck) {
+
+    Bitboard ownPieces = SidePieces(position, isWhite);
+    while (ownPieces) {
+        int pos = PopLSB(ownPieces);
+        char piece = position.boardState[pos];
+        switch (PieceTypeOf(piece)) {
+            case PAWN:
+                GeneratePawnMoves(position, pos, isWhite, moves);
+                break;
+            case KNIGHT:
+                GenerateKnightMoves(position, pos, isWhite, moves);
+                break;
+            case BISHOP:
+                GenerateBishopMoves(position, pos, isWhite, moves);
+                break;
+            case ROOK:
+                GenerateRookMoves(position, pos, isWhite, moves);
+                break;
+            case QUEEN:
+                GenerateBishopMoves(position, pos, isWhite, moves);
+                GenerateRookMoves(position, pos, isWhite, moves);
+                break;
+            case KING:
+                GenerateKingMoves(position, pos, isWhite, moves, skipCastlingCheck);
+                break;
+        }
+    }
+}
+
+Bitboard PawnTargets(const BoardPosition& position, int pos, bool isWhite) {
+    const int BOARD_SIZE = 8;
+    int direction = isWhite ? -BOARD_SIZE : BOARD_SIZE;
+    int row = pos / BOARD_SIZE;
+    Bitboard targets = pawnAttacks[SideIndex(isWhite)][pos] & SidePieces(position, !isWhite);
+
+    int newPos = pos + direction;
+    if (newPos >= 0 && newPos < 64 && position.boardState[newPos] == ' ') {
+        targets |= SquareBit(newPos);
+
+        if ((isWhite && row == 6) || (!isWhite && row == 1)) {
+            newPos += direction;
+            if (position.boardState[newPos] == ' ') {
+                targets |= SquareBit(newPos);
+            }
         }
     }
-    if (kingPos == -1) return false;
+    return targets;
+}
 
-    std::vector<Move> opponentMoves = GenerateMoves(position, !isWhiteKing, /*skipCastlingCheck=*/true);
+bool CanCaptureEnPassant(const BoardPosition& position, int pos, bool isWhite) {
+    int target = position.enPassantTargetSquare;
+    if (target < 0 || target / 8 != (isWhite ? 2 : 5)) return false;
 
-    for (const Move& move : opponentMoves) {
-        int endPos = std::stoi(move.notation.substr(move.notation.length() - 2));
-        if (endPos == kingPos) return true;
+    return (pawnAttacks[SideIndex(isWhite)][pos] & SquareBit(target)) != 0;
+}
+
+Bitboard PinnedPieces(const BoardPosition& position, bool isWhite, int kingSquare) {
+    Bitboard enemyQueens = Pieces(position, !isWhite, QUEEN);
+    Bitboard snipers = (BishopAttacks(kingSquare, 0) & (Pieces(position, !isWhite, BISHOP) | enemyQueens)) |
+                       (RookAttacks(kingSquare, 0) & (Pieces(position, !isWhite, ROOK) | enemyQueens));
+    Bitboard pinned = 0;
+
+    while (snipers) {
+        Bitboard blockers = betweenMasks[kingSquare][PopLSB(snipers)] & position.occupied;
+        if (blockers && !(blockers & (blockers - 1))) {
+            pinned |= blockers & SidePieces(position, isWhite);
+        }
     }
-    return false;
+    return pinned;
 }
 
-std::vector<Move> GenerateMoves(const BoardPosition& position, bool isWhite, bool skipCastlingCheck) {
-    const std::string& boardState = position.boardState;
-    std::vector<Move> moves;
-    const int BOARD_SIZE = 8;
-    for (int i = 0; i < boardState.size(); ++i) {
-        char piece = boardState[i];
-        if (piece == ' ' || (isWhite && islower(piece)) || (!isWhite && isupper(piece))) continue;
-        int row = i / BOARD_SIZE;
-        int col = i % BOARD_SIZE;
-        if ((isWhite && piece == 'P') || (!isWhite && piece == 'p')) {
-            GeneratePawnMoves(boardState, row, col, i, isWhite, moves, position.enPassantTargetSquare % 8);
-        } else if ((isWhite && piece == 'N') || (!isWhite && piece == 'n')) {
-            GenerateKnightMoves(boardState, row, col, i, isWhite, moves);
-        } else if ((isWhite && piece == 'B') || (!isWhite && piece == 'b')) {
-            GenerateBishopMoves(boardState, row, col, i, isWhite, moves, piece);
-        } else if ((isWhite && piece == 'R') || (!isWhite && piece == 'r')) {
-            GenerateRookMoves(boardState, row, col, i, isWhite, moves, piece);
-        } else if ((isWhite && piece == 'Q') || (!isWhite && piece == 'q')) {
-            GenerateBishopMoves(boardState, row, col, i, isWhite, moves, piece);
-            GenerateRookMoves(boardState, row, col, i, isWhite, moves, piece);
-        } else if ((isWhite && piece == 'K') || (!isWhite && piece == 'k')) {
-            GenerateKingMoves(boardState, row, col, i, isWhite, moves, position, skipCastlingCheck);
-        }
-    }
-    return moves;
-}
-
-int Minimax(const BoardPosition& position, int depth, int alpha, int beta, bool maximizingPlayer) {
+bool IsLegalEnPassant(const BoardPosition& position, const Move& move, bool isWhite, int kingSquare) {
+    Bitboard captured = SquareBit(move.EnPassantCapturePos());
+    Bitboard occupied = (position.occupied ^ SquareBit(move.From()) ^ captured) | SquareBit(move.To());
+
+    return !(AttackersTo(position, kingSquare, !isWhite, occupied) & ~captured);
+}
+
+void GenerateLegalMoves(const BoardPosition& position, bool isWhite, MoveList& moves, MoveGenType genType) {
+    Bitboard king = Pieces(position, isWhite, KING);
+    if (!king) {
+        MoveList allMoves;
+        GenerateMoves(position, isWhite, allMoves);
+        for (const Move& move : allMoves) {
+            bool isNoisy = IsCapture(position, move) || move.IsPromotion();
+            if (genType == ALL_MOVES || isNoisy == (genType == CAPTURES)) {
+                moves.push_back(move);
+            }
+        }
+        return;
+    }
+
+    int kingSquare = LSB(king);
+    Bitboard ownPieces = SidePieces(position, isWhite);
+    Bitboard checkers = AttackersTo(position, kingSquare, !isWhite);
+    Bitboard occupiedWithoutKing = position.occupied ^ king;
+    bool isDoubleCheck = (checkers & (checkers - 1)) != 0;
+
+    Bitboard targetMask = checkers ? (betweenMasks[kingSquare][LSB(checkers)] | checkers) : ~ownPieces;
+    Bitboard typeMask = genType == CAPTURES ? SidePieces(position, !isWhite) :
+                        genType == QUIETS ? ~position.occupied : ~0ULL;
+    Bitboard pinned = PinnedPieces(position, isWhite, kingSquare);
+    const Bitboard promotionRank = isWhite ? 0xFFULL : 0xFF00000000000000ULL;
+
+    Bitboard pieces = isDoubleCheck ? king : ownPieces;
+    while (pieces) {
+        int pos = PopLSB(pieces);
+        Bitboard allowed = targetMask;
+        if (pinned & SquareBit(pos)) {
+            allowed &= lineMasks[kingSquare][pos];
+        }
+
+        switch (PieceTypeOf(position.boardState[pos])) {
+            case PAWN: {
+                Bitboard targets = PawnTargets(position, pos, isWhite) & allowed;
+                AddMoves(pos, targets & ~promotionRank & typeMask, moves);
+
+                Bitboard promotions = genType == QUIETS ? 0 : targets & promotionRank;
+                while (promotions) {
+                    int newPos = PopLSB(promotions);
+                    for (int promotion = QUEEN; promotion >= KNIGHT; promotion--) {
+                        moves.push_back(Move(pos, newPos, PROMOTION, promotion));
+                    }
+                }
+
+                if (genType != QUIETS && CanCaptureEnPassant(position, pos, isWhite)) {
+                    Move enPassant(pos, position.enPassantTargetSquare, EN_PASSANT);
+                    if (IsLegalEnPassant(position, enPassant, isWhite, kingSquare)) {
+                        moves.push_back(enPassant);
+                    }
+                }
+                break;
+            }
+            case KNIGHT:
+                AddMoves(pos, knightAttacks[pos] & allowed & typeMask, moves);
+                break;
+            case BISHOP:
+                AddMoves(pos, BishopAttacks(pos, position.occupied) & allowed & typeMask, moves);
+                break;
+            case ROOK:
+                AddMoves(pos, RookAttacks(pos, position.occupied) & allowed & typeMask, moves);
+                break;
+            case QUEEN:
+                AddMoves(pos, QueenAttacks(pos, position.occupied) & allowed & typeMask, moves);
+                break;
+            case KING: {
+                Bitboard targets = kingAttacks[pos] & ~ownPieces & typeMask;
+                while (targets) {
+                    int to = PopLSB(targets);
+                    if (!AttackersTo(position, to, !isWhite, occupiedWithoutKing)) {
+                        moves.push_back(Move(pos, to));
+                    }
+                }
+                if (!checkers && genType != CAPTURES) {
+                    GenerateCastlingMoves(position, pos, isWhite, moves);
+                }
+                break;
+            }
+        }
+    }
+}
+
+bool IsLegalMove(const BoardPosition& position, const Move& move, bool isWhite) {
+    int from = move.From();
+    int to = move.To();
+    Bitboard ownPieces = SidePieces(position, isWhite);
+    if (move.IsNull() || !(ownPieces & SquareBit(from)) || (ownPieces & SquareBit(to)) ||
+        (!move.IsPromotion() && move.Promotion() != KNIGHT)) {
+        return false;
+    }
+
+    Bitboard king = Pieces(position, isWhite, KING);
+    int pieceType = PieceTypeOf(position.boardState[from]);
+    if (!king || (move.IsCastling() && pieceType == KING)) {
+        MoveList moves;
+        GenerateLegalMoves(position, isWhite, moves);
+        return std::find(moves.begin(), moves.end(), move) != moves.end();
+    }
+
+    int kingSquare = LSB(king);
+    const Bitboard promotionRank = isWhite ? 0xFFULL : 0xFF00000000000000ULL;
+    Bitboard targets = 0;
+    switch (pieceType) {
+        case PAWN:
+            if (move.IsEnPassant()) {
+                return to == position.enPassantTargetSquare && CanCaptureEnPassant(position, from, isWhite) &&
+                       IsLegalEnPassant(position, move, isWhite, kingSquare);
+            }
+            if (move.IsCastling() || move.IsPromotion() != ((promotionRank & SquareBit(to)) != 0)) return false;
+            targets = PawnTargets(position, from, isWhite);
+            break;
+        case KNIGHT: targets = knightAttacks[from]; break;
+        case BISHOP: targets = BishopAttacks(from, position.occupied); break;
+        case ROOK: targets = RookAttacks(from, position.occupied); break;
+        case QUEEN: targets = QueenAttacks(from, position.occupied); break;
+        case KING:
+            return move.Flag() == NORMAL_MOVE && (kingAttacks[from] & SquareBit(to)) &&
+                   !AttackersTo(position, to, !isWhite, position.occupied ^ king);
+    }
+    if (!(targets & SquareBit(to)) || (pieceType != PAWN && move.Flag() != NORMAL_MOVE)) {
+        return false;
+    }
+
+    Bitboard checkers = AttackersTo(position, kingSquare, !isWhite);
+    if (checkers & (checkers - 1)) return false;
+    if (checkers && !((betweenMasks[kingSquare][LSB(checkers)] | checkers) & SquareBit(to))) return false;
+
+    return !(PinnedPieces(position, isWhite, kingSquare) & SquareBit(from)) ||
+           (lineMasks[kingSquare][from] & SquareBit(to));
+}
+
+int CountMoves(const BoardPosition& position, bool isWhite) {
+    Bitboard ownPieces = SidePieces(position, isWhite);
+    Bitboard targets = ~ownPieces;
+    int count = 0;
+
+    while (ownPieces) {
+        int pos = PopLSB(ownPieces);
+        switch (PieceTypeOf(position.boardState[pos])) {
+            case PAWN:
+                count += PopCount(PawnTargets(position, pos, isWhite));
+                if (CanCaptureEnPassant(position, pos, isWhite)) count++;
+                break;
+            case KNIGHT:
+                count += PopCount(knightAttacks[pos] & targets);
+                break;
+            case BISHOP:
+                count += PopCount(BishopAttacks(pos, position.occupied) & targets);
+                break;
+            case ROOK:
+                count += PopCount(RookAttacks(pos, position.occupied) & targets);
+                break;
+            case QUEEN:
+                count += PopCount(QueenAttacks(pos, position.occupied) & targets);
+                break;
+            case KING:
+                count += PopCount(kingAttacks[pos] & targets);
+                break;
+        }
+    }
+    return count;
+}
+
+int Minimax(BoardPosition& position, int depth, int alpha, int beta, bool maximizingPlayer) {
     if (depth == 0) {
         return EvaluateBoard(position, 0);
     }
 
-    std::vector<Move> moves = GenerateMoves(position, maximizingPlayer);
+    MoveList moves;
+    GenerateLegalMoves(position, maximizingPlayer, moves);
 
     if (moves.empty()) {
         return maximizingPlayer ? -20000 : 20000;
@@ -995,8 +2142,9 @@ int Minimax(const BoardPosition& position, int depth, int alpha, int beta, bool
     if (maximizingPlayer) {
         int maxEval = -2147483647;
         for (const Move& move : moves) {
-            BoardPosition newPosition = ApplyMove(position, move);
-            int eval = Minimax(newPosition, depth - 1, alpha, beta, false);
+            MakeMove(position, move);
+            int eval = Minimax(position, depth - 1, alpha, beta, false);
+            UnmakeMove(position);
             maxEval = customMax(maxEval, eval);
             alpha = customMax(alpha, eval);
             if (beta <= alpha) {
@@ -1007,8 +2155,9 @@ int Minimax(const BoardPosition& position, int depth, int alpha, int beta, bool
     } else {
         int minEval = 2147483647;
         for (const Move& move : moves) {
-            BoardPosition newPosition = ApplyMove(position, move);
-            int eval = Minimax(newPosition, depth - 1, alpha, beta, true);
+            MakeMove(position, move);
+            int eval = Minimax(position, depth - 1, alpha, beta, true);
+            UnmakeMove(position);
             minEval = customMin(minEval, eval);
             beta = customMin(beta, eval);
             if (beta <= alpha) {
@@ -1019,181 +2168,64 @@ int Minimax(const BoardPosition& position, int depth, int alpha, int beta, bool
     }
 }
 
-bool IsValidMove(const std::string& boardState, int row, int col, bool isWhite) {
-    const int BOARD_SIZE = 8;
-    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
-        return false;
-    }
-
-    int pos = row * BOARD_SIZE + col;
-    char piece = boardState[pos];
-
-    if (piece == ' ') {
-        return true;
+void AddMoves(int startPos, Bitboard targets, MoveList& moves) {
+    while (targets) {
+        moves.push_back(Move(startPos, PopLSB(targets)));
     }
-
-    return (isWhite && islower(piece)) || (!isWhite && isupper(piece));
-}
-
-void AddMove(const std::string& boardState, int startPos, int endPos, char piece, 
-             std::vector<Move>& moves) {
-    std::string startPosStr = (startPos < 10) ? "0" + std::to_string(startPos) : std::to_string(startPos);
-    std::string endPosStr = (endPos < 10) ? "0" + std::to_string(endPos) : std::to_string(endPos);
-    
-    std::string notation = piece + startPosStr + endPosStr;
-
-    moves.push_back({notation});
 }
 
-void GeneratePawnMoves(const std::string& boardState, int row, int col, int pos,
-    bool isWhite, std::vector<Move>& moves, int enPassantCol)
+void GeneratePawnMoves(const BoardPosition& position, int pos,
+    bool isWhite, MoveList& moves)
 {
-    const int BOARD_SIZE = 8;
-    char piece = boardState[pos];
-    int direction = isWhite ? -1 : 1;
-    bool lastRank = (isWhite && row + direction == 0) || (!isWhite && row + direction == 7);
-
-    int newRow = row + direction;
-    if (newRow >= 0 && newRow < BOARD_SIZE) {
-        int newPos = newRow * BOARD_SIZE + col;
-        if (boardState[newPos] == ' ') {
-            AddMove(boardState, pos, newPos, piece, moves);
-
-            if (!lastRank && ((isWhite && row == 6) || (!isWhite && row == 1))) {
-                newRow = row + 2 * direction;
-                if (newRow >= 0 && newRow < BOARD_SIZE) {
-                    newPos = newRow * BOARD_SIZE + col;
-                    if (boardState[newPos] == ' ') {
-                        AddMove(boardState, pos, newPos, piece, moves);
-                    }
-                }
-            }
-        }
-    }
+    const Bitboard promotionRank = isWhite ? 0xFFULL : 0xFF00000000000000ULL;
+    Bitboard targets = PawnTargets(position, pos, isWhite);
 
-    for (int dc : {-1, 1}) {
-        int newCol = col + dc;
-        newRow = row + direction;
-        if (newRow >= 0 && newRow < BOARD_SIZE && newCol >= 0 && newCol < BOARD_SIZE) {
-            int newPos = newRow * BOARD_SIZE + newCol;
-            char targetPiece = boardState[newPos];
+    AddMoves(pos, targets & ~promotionRank, moves);
 
-            bool isOpponentPiece = (isWhite && islower(targetPiece)) || (!isWhite && isupper(targetPiece));
-            if (targetPiece != ' ' && isOpponentPiece) {
-                AddMove(boardState, pos, newPos, piece, moves);
-            }
+    Bitboard promotions = targets & promotionRank;
+    while (promotions) {
+        int newPos = PopLSB(promotions);
+        for (int promotion = QUEEN; promotion >= KNIGHT; promotion--) {
+            moves.push_back(Move(pos, newPos, PROMOTION, promotion));
         }
     }
 
-    if ((isWhite && row == 3) || (!isWhite && row == 4)) {
-        if (enPassantCol >= 0 && abs(col - enPassantCol) == 1) {
-            int newPos = (row + direction) * BOARD_SIZE + enPassantCol;
-            int capturePos = row * BOARD_SIZE + enPassantCol;
-
-            Move enPassantMove;
-            enPassantMove.notation = piece + std::to_string(pos) + std::to_string(newPos);
-            enPassantMove.isEnPassant = true;
-            enPassantMove.enPassantCapturePos = capturePos;
-            moves.push_back(enPassantMove);
-        }
+    if (CanCaptureEnPassant(position, pos, isWhite)) {
+        moves.push_back(Move(pos, position.enPassantTargetSquare, EN_PASSANT));
     }
 }
 
-void GenerateKnightMoves(const std::string& boardState, int row, int col, int pos, 
-                         bool isWhite, std::vector<Move>& moves) {
-    char piece = isWhite ? 'N' : 'n';
-    const std::vector<std::pair<int, int>> knightMoves = {
-        {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
-        {1, -2}, {1, 2}, {2, -1}, {2, 1}
-    };
-    
-    const int BOARD_SIZE = 8;
-    for (const auto& move : knightMoves) {
-        int newRow = row + move.first;
-        int newCol = col + move.second;
-        
-        if (IsValidMove(boardState, newRow, newCol, isWhite)) {
-            int newPos = newRow * BOARD_SIZE + newCol;
-            AddMove(boardState, pos, newPos, piece, moves);
-        }
-    }
+void GenerateKnightMoves(const BoardPosition& position, int pos, 
+                         bool isWhite, MoveList& moves) {
+    AddMoves(pos, knightAttacks[pos] & ~SidePieces(position, isWhite), moves);
 }
 
-void GenerateBishopMoves(const std::string& boardState, int row, int col, int pos, 
-                         bool isWhite, std::vector<Move>& moves, char actualPiece) {
-    char piece = actualPiece ? actualPiece : (isWhite ? 'B' : 'b');
-    const std::vector<std::pair<int, int>> directions = {
-        {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
-    };
-    
-    const int BOARD_SIZE = 8;
-    for (const auto& dir : directions) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
-        
-        while (IsValidMove(boardState, newRow, newCol, isWhite)) {
-            int newPos = newRow * BOARD_SIZE + newCol;
-            AddMove(boardState, pos, newPos, piece, moves);
-            
-            if (boardState[newPos] != ' ') {
-                break;
-            }
-            
-            newRow += dir.first;
-            newCol += dir.second;
-        }
-    }
+void GenerateBishopMoves(const BoardPosition& position, int pos, 
+                         bool isWhite, MoveList& moves) {
+    AddMoves(pos, BishopAttacks(pos, position.occupied) & ~SidePieces(position, isWhite), moves);
 }
 
-void GenerateRookMoves(const std::string& boardState, int row, int col, int pos, 
-                       bool isWhite, std::vector<Move>& moves, char actualPiece) {
-    char piece = actualPiece ? actualPiece : (isWhite ? 'R' : 'r');
-    const std::vector<std::pair<int, int>> directions = {
-        {-1, 0}, {1, 0}, {0, -1}, {0, 1}
-    };
-    
-    const int BOARD_SIZE = 8;
-    for (const auto& dir : directions) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
-        
-        while (IsValidMove(boardState, newRow, newCol, isWhite)) {
-            int newPos = newRow * BOARD_SIZE + newCol;
-            AddMove(boardState, pos, newPos, piece, moves);
-            
-            if (boardState[newPos] != ' ') {
-                break;
-            }
-            
-            newRow += dir.first;
-            newCol += dir.second;
-        }
-    }
+void GenerateRookMoves(const BoardPosition& position, int pos, 
+                       bool isWhite, MoveList& moves) {
+    AddMoves(pos, RookAttacks(pos, position.occupied) & ~SidePieces(position, isWhite), moves);
 }
 
-void GenerateKingMoves(const std::string& boardState, int row, int col, int pos, 
-                      bool isWhite, std::vector<Move>& moves, const BoardPosition& position, bool skipCastlingCheck) {
-    char piece = isWhite ? 'K' : 'k';
-    const std::vector<std::pair<int, int>> directions = {
-        {-1, -1}, {-1, 0}, {-1, 1},
-        {0, -1},           {0, 1},
-        {1, -1},  {1, 0},  {1, 1}
-    };
-
-    const int BOARD_SIZE = 8;
-    for (const auto& dir : directions) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
+void GenerateKingMoves(const BoardPosition& position, int pos, 
+                      bool isWhite, MoveList& moves, bool skipCastlingCheck) {
+    AddMoves(pos, kingAttacks[pos] & ~SidePieces(position, isWhite), moves);
 
-        if (IsValidMove(boardState, newRow, newCol, isWhite)) {
-            int newPos = newRow * BOARD_SIZE + newCol;
-            AddMove(boardState, pos, newPos, piece, moves);
-        }
+    if (!skipCastlingCheck) {
+        GenerateCastlingMoves(position, pos, isWhite, moves);
     }
+}
 
-    auto posStr = [](int p) { return (p < 10 ? "0" : "") + std::to_string(p); };
+void GenerateCastlingMoves(const BoardPosition& position, int pos,
+                           bool isWhite, MoveList& moves) {
+    int row = pos / 8;
+    int col = pos % 8;
+    const char* boardState = position.boardState;
 
-    if (!skipCastlingCheck && ((isWhite && row == 7 && col == 4) || (!isWhite && row == 0 && col == 4))) {
+    if ((isWhite && row == 7 && col == 4) || (!isWhite && row == 0 && col == 4)) {
         int baseRow = isWhite ? 7 : 0;
         char rook = isWhite ? 'R' : 'r';
 
@@ -1204,22 +2236,13 @@ void GenerateKingMoves(const std::string& boardState, int row, int col, int pos,
             boardState[baseRow * 8 + 7] == rook) {
             bool safe = true;
             for (int c = 4; c <= 6; ++c) {
-                BoardPosition tempPosition = position;
-                tempPosition.boardState[baseRow * 8 + 4] = ' ';
-                tempPosition.boardState[baseRow * 8 + c] = piece;
-                if (IsKingInCheck(tempPosition, isWhite)) {
+                if (IsSquareAttacked(position, baseRow * 8 + c, !isWhite)) {
                     safe = false;
                     break;
                 }
-                tempPosition.boardState[baseRow * 8 + c] = ' ';
-                tempPosition.boardState[baseRow * 8 + 4] = piece;
             }
             if (safe) {
-                Move castlingMove;
-                castlingMove.notation = piece + posStr(pos) + posStr(baseRow * 8 + 6);
-                castlingMove.isCastling = true;
-                castlingMove.isKingsideCastling = true;
-                moves.push_back(castlingMove);
+                moves.push_back(Move(pos, baseRow * 8 + 6, CASTLING));
             }
         }
 
@@ -1231,155 +2254,232 @@ void GenerateKingMoves(const std::string& boardState, int row, int col, int pos,
             boardState[baseRow * 8 + 0] == rook) {
             bool safe = true;
             for (int c = 2; c <= 4; ++c) {
-                BoardPosition tempPosition = position;
-                tempPosition.boardState[baseRow * 8 + 4] = ' ';
-                tempPosition.boardState[baseRow * 8 + c] = piece;
-                if (IsKingInCheck(tempPosition, isWhite)) {
+                if (IsSquareAttacked(position, baseRow * 8 + c, !isWhite)) {
                     safe = false;
                     break;
                 }
-                tempPosition.boardState[baseRow * 8 + c] = ' ';
-                tempPosition.boardState[baseRow * 8 + 4] = piece;
             }
             if (safe) {
-                Move castlingMove;
-                castlingMove.notation = piece + posStr(pos) + posStr(baseRow * 8 + 2);
-                castlingMove.isCastling = true;
-                castlingMove.isKingsideCastling = false;
-                moves.push_back(castlingMove);
+                moves.push_back(Move(pos, baseRow * 8 + 2, CASTLING));
             }
         }
     }
 }
 
-int EvaluateBoard(const BoardPosition& position, int searchDepth) {
-    const std::string& boardState = position.boardState;
-    const int BOARD_SIZE = 8;
-    uint64_t key = GetZobristKey(position.boardState);
-    
-    auto it = evaluationCache.find(key);
-    if (it != evaluationCache.end()) {
-        return it->second;
+// Move numbers the evaluation treats alike: the opening terms change at moves 1, 2, 3, 4 and 10
+inline int EvalMoveBucket(int fullMoveNumber) {
+    if (fullMoveNumber <= 4) return customMax(fullMoveNumber, 0);
+    return fullMoveNumber <= 10 ? 5 : 6;
+}
+
+// Personality terms change the score, and non-standard personalities only apply the full set near the leaves
+inline uint64_t EvalCacheKey(const BoardPosition& position, int searchDepth) {
+    bool fullPersonality = currentPersonality != STANDARD && searchDepth <= 2;
+    return GetZobristKey(position) ^ zobristPersonality[currentPersonality][fullPersonality] ^
+           zobristMoveBucket[EvalMoveBucket(position.fullMoveNumber)];
+}
+
+inline bool ProbeEvalCache(uint64_t key, int& score) {
+    uint64_t data = evaluationCache[key & (EVAL_CACHE_SIZE - 1)].load(std::memory_order_relaxed);
+    if ((uint32_t)(data >> 32) != (uint32_t)(key >> 32)) {
+        return false;
+    }
+    score = (int32_t)(uint32_t)data;
+    return true;
+}
+
+inline void StoreEvalCache(uint64_t key, int score) {
+    uint64_t data = (key & 0xFFFFFFFF00000000ULL) | (uint32_t)score;
+    evaluationCache[key & (EVAL_CACHE_SIZE - 1)].store(data, std::memory_order_relaxed);
+}
+
+// Pawn-only terms, keyed by the pawn Zobrist key; each search thread keeps its own table
+struct PawnEntry {
+    uint64_t key;
+    int score;
+    int structureScore[2];
+    Bitboard passedPawns[2];
+};
+
+const size_t PAWN_TABLE_SIZE = 1 << 14;
+thread_local std::vector<PawnEntry> pawnHashTable(PAWN_TABLE_SIZE);
+
+static const int pawnTable[64] = {
+    0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+    5,  5, 10, 25, 25, 10,  5,  5,
+    0,  0,  0, 20, 20,  0,  0,  0,
+    5, -5,-10,  0,  0,-10, -5,  5,
+    5, 10, 10,-20,-20, 10, 10,  5,
+    0,  0,  0,  0,  0,  0,  0,  0
+};
+
+void EvaluatePawns(const BoardPosition& position, PawnEntry& entry) {
+    Bitboard whitePawnsBB = Pieces(position, true, PAWN);
+    Bitboard blackPawnsBB = Pieces(position, false, PAWN);
+    int score = 0;
+
+    int whitePawns[8] = {0};
+    int blackPawns[8] = {0};
+    for (int file = 0; file < 8; file++) {
+        whitePawns[file] = PopCount(whitePawnsBB & fileMasks[file]);
+        blackPawns[file] = PopCount(blackPawnsBB & fileMasks[file]);
+        if (whitePawns[file] > 1) {
+            score -= 20 * (whitePawns[file] - 1);
+        }
+        if (blackPawns[file] > 1) {
+            score += 20 * (blackPawns[file] - 1);
+        }
+    }
+
+    entry.passedPawns[0] = 0;
+    entry.passedPawns[1] = 0;
+
+    for (Bitboard b = whitePawnsBB; b; ) {
+        int pawnPos = PopLSB(b);
+        int file = pawnPos % 8;
+        score += pawnTable[pawnPos];
+
+        bool isIsolated = true;
+        if (file > 0 && whitePawns[file-1] > 0) isIsolated = false;
+        if (file < 7 && whitePawns[file+1] > 0) isIsolated = false;
+
+        if (isIsolated) {
+            score -= 15;
+        }
+
+        if ((passedPawnMasks[0][pawnPos] & blackPawnsBB) == 0) {
+            entry.passedPawns[0] |= SquareBit(pawnPos);
+        }
+    }
+
+    for (Bitboard b = blackPawnsBB; b; ) {
+        int pawnPos = PopLSB(b);
+        int file = pawnPos % 8;
+        score -= pawnTable[63 - pawnPos];
+
+        bool isIsolated = true;
+        if (file > 0 && blackPawns[file-1] > 0) isIsolated = false;
+        if (file < 7 && blackPawns[file+1] > 0) isIsolated = false;
+
+        if (isIsolated) {
+            score += 15;
+        }
+
+        if ((passedPawnMasks[1][pawnPos] & whitePawnsBB) == 0) {
+            entry.passedPawns[1] |= SquareBit(pawnPos);
+        }
+    }
+
+    entry.score = score;
+    entry.structureScore[0] = EvaluatePawnStructure(position, true);
+    entry.structureScore[1] = EvaluatePawnStructure(position, false);
+}
+
+const PawnEntry& ProbePawnTable(const BoardPosition& position) {
+    PawnEntry& entry = pawnHashTable[position.pawnHash & (PAWN_TABLE_SIZE - 1)];
+    if (entry.key != position.pawnHash || entry.key == 0) {
+        EvaluatePawns(position, entry);
+        entry.key = position.pawnHash;
     }
-    int score = 0;
-    
-    const int PAWN_VALUE = 100;
-    const int KNIGHT_VALUE = 320;
-    const int BISHOP_VALUE = 330;
-    const int ROOK_VALUE = 500;
-    const int QUEEN_VALUE = 900;
-    const int KING_VALUE = 20000;
+    return entry;
+}
 
-    int whitePawns[8] = {0};
-    int blackPawns[8] = {0};
-    bool whiteHasBishopPair = false;
-    bool blackHasBishopPair = false;
-    int whiteBishops = 0, blackBishops = 0;
-    int whitePawnCount = 0, blackPawnCount = 0;
-    int whiteRookCount = 0, blackRookCount = 0;
-    int whiteKnightCount = 0, blackKnightCount = 0;
-    int whiteQueenCount = 0, blackQueenCount = 0;
-    int whiteKingPos = -1, blackKingPos = -1;
-    
+const int PAWN_VALUE = 100;
+const int KNIGHT_VALUE = 320;
+const int BISHOP_VALUE = 330;
+const int ROOK_VALUE = 500;
+const int QUEEN_VALUE = 900;
+const int KING_VALUE = 20000;
+
+const size_t MATERIAL_TABLE_SIZE = 1 << 13;
+thread_local std::vector<MaterialEntry> materialTable(MATERIAL_TABLE_SIZE);
+
+void EvaluateMaterial(uint64_t key, MaterialEntry& entry) {
+    static const int pieceValues[6] = { PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE };
+    int nonPawnMaterial[2] = {0, 0};
+    int score = 0;
     int totalMaterial = 0;
-    
-    std::vector<int> whitePawnPositions;
-    std::vector<int> blackPawnPositions;
-    std::vector<int> whiteRookPositions;
-    std::vector<int> blackRookPositions;
-    std::vector<int> whiteKnightPositions;
-    std::vector<int> blackKnightPositions;
-    std::vector<int> whiteBishopPositions;
-    std::vector<int> blackBishopPositions;
-    
-    for (size_t i = 0; i < boardState.size(); i++) {
-        char piece = boardState[i];
-        int file = i % 8;
-        int rank = i / 8;
-        int pos = rank * BOARD_SIZE + file;
-        
-        switch (piece) {
-            case 'P': 
-                score += PAWN_VALUE; 
-                whitePawns[file]++;
-                whitePawnCount++;
-                whitePawnPositions.push_back(pos);
-                totalMaterial += PAWN_VALUE;
-                break;
-            case 'p': 
-                score -= PAWN_VALUE; 
-                blackPawns[file]++;
-                blackPawnCount++;
-                blackPawnPositions.push_back(pos);
-                totalMaterial += PAWN_VALUE;
-                break;
-            case 'N': 
-                score += KNIGHT_VALUE;
-                whiteKnightCount++;
-                whiteKnightPositions.push_back(pos);
-                totalMaterial += KNIGHT_VALUE;
-                break;
-            case 'n': 
-                score -= KNIGHT_VALUE;
-                blackKnightCount++;
-                blackKnightPositions.push_back(pos);
-                totalMaterial += KNIGHT_VALUE;
-                break;
-            case 'B': 
-                score += BISHOP_VALUE;
-                whiteBishopPositions.push_back(pos);
-                whiteBishops++;
-                totalMaterial += BISHOP_VALUE;
-                break;
-            case 'b': 
-                score -= BISHOP_VALUE;
-                blackBishopPositions.push_back(pos);
-                blackBishops++;
-                totalMaterial += BISHOP_VALUE;
-                break;
-            case 'R': 
-                score += ROOK_VALUE;
-                whiteRookCount++;
-                whiteRookPositions.push_back(pos);
-                totalMaterial += ROOK_VALUE;
-                break;
-            case 'r': 
-                score -= ROOK_VALUE;
-                blackRookCount++;
-                blackRookPositions.push_back(pos);
-                totalMaterial += ROOK_VALUE;
-                break;
-            case 'Q': 
-                score += QUEEN_VALUE;
-                whiteQueenCount++;
-                totalMaterial += QUEEN_VALUE;
-                break;
-            case 'q': 
-                score -= QUEEN_VALUE;
-                blackQueenCount++;
-                totalMaterial += QUEEN_VALUE;
-                break;
-            case 'K': 
-                score += KING_VALUE;
-                whiteKingPos = pos;
-                break;
-            case 'k': 
-                score -= KING_VALUE;
-                blackKingPos = pos;
-                break;
+
+    for (int type = PAWN; type <= KING; type++) {
+        int whiteCount = MaterialCount(key, true, type);
+        int blackCount = MaterialCount(key, false, type);
+        score += (whiteCount - blackCount) * pieceValues[type];
+        if (type == KING) break;
+
+        totalMaterial += (whiteCount + blackCount) * pieceValues[type];
+        if (type != PAWN) {
+            nonPawnMaterial[0] += whiteCount * pieceValues[type];
+            nonPawnMaterial[1] += blackCount * pieceValues[type];
         }
     }
-    
-    int gamePhase = 0;
+
+    if (MaterialCount(key, true, BISHOP) >= 2) score += 50;
+    if (MaterialCount(key, false, BISHOP) >= 2) score -= 50;
+    entry.score = score;
+
     const int OPENING_THRESHOLD = 5000;
     const int MIDDLEGAME_THRESHOLD = 3000;
+    entry.gamePhase = totalMaterial <= MIDDLEGAME_THRESHOLD ? 2 : (totalMaterial <= OPENING_THRESHOLD ? 1 : 0);
+
+    // Without pawns, a lone minor piece cannot mate and a minor piece's worth of advantage rarely wins
+    for (int side = 0; side < 2; side++) {
+        bool isWhite = side == 0;
+        entry.scale[side] = SCALE_NORMAL;
+        if (MaterialCount(key, isWhite, PAWN) > 0) continue;
+
+        int lead = nonPawnMaterial[side] - nonPawnMaterial[1 - side];
+        if (nonPawnMaterial[side] <= BISHOP_VALUE) {
+            entry.scale[side] = 0;
+        } else if (lead > 0 && lead <= BISHOP_VALUE) {
+            entry.scale[side] = SCALE_NORMAL / 4;
+        }
+    }
+
+    // Drawn when one side has only its king and the other cannot mate either
+    bool whiteBare = nonPawnMaterial[0] == 0 && MaterialCount(key, true, PAWN) == 0;
+    bool blackBare = nonPawnMaterial[1] == 0 && MaterialCount(key, false, PAWN) == 0;
+    entry.isDrawn = (whiteBare && entry.scale[1] == 0) || (blackBare && entry.scale[0] == 0);
+}
+
+const MaterialEntry& ProbeMaterialTable(const BoardPosition& position) {
+    uint64_t key = position.materialKey;
+    MaterialEntry& entry = materialTable[((key * 0x9E3779B97F4A7C15ULL) >> 51) & (MATERIAL_TABLE_SIZE - 1)];
+    if (entry.key != key || key == 0) {
+        EvaluateMaterial(key, entry);
+        entry.key = key;
+    }
+    return entry;
+}
+
+int EvaluateBoard(const BoardPosition& position, int searchDepth) {
+    const char* boardState = position.boardState;
+    uint64_t key = EvalCacheKey(position, searchDepth);
     
-    if (totalMaterial <= MIDDLEGAME_THRESHOLD) {
-        gamePhase = 2;
-    } else if (totalMaterial <= OPENING_THRESHOLD) {
-        gamePhase = 1;
+    int score = 0;
+    if (ProbeEvalCache(key, score)) {
+        return score;
     }
     
+    Bitboard whitePawnsBB = Pieces(position, true, PAWN);
+    Bitboard blackPawnsBB = Pieces(position, false, PAWN);
+    Bitboard whiteKnightsBB = Pieces(position, true, KNIGHT);
+    Bitboard blackKnightsBB = Pieces(position, false, KNIGHT);
+    Bitboard whiteBishopsBB = Pieces(position, true, BISHOP);
+    Bitboard blackBishopsBB = Pieces(position, false, BISHOP);
+    Bitboard whiteRooksBB = Pieces(position, true, ROOK);
+    Bitboard blackRooksBB = Pieces(position, false, ROOK);
+
+    const MaterialEntry& material = ProbeMaterialTable(position);
+    Bitboard whiteKingBB = Pieces(position, true, KING);
+    Bitboard blackKingBB = Pieces(position, false, KING);
+    int whiteKingPos = whiteKingBB ? LSB(whiteKingBB) : -1;
+    int blackKingPos = blackKingBB ? LSB(blackKingBB) : -1;
+    
+    score += material.score;
+    int gamePhase = material.gamePhase;
+    
     if (gamePhase == 0) {
         int openingScore = EvaluateOpeningPrinciples(position);
         
@@ -1394,47 +2494,15 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
     }
     
     if (gamePhase == 0) {
-        for (int i = 0; i < 64; i++) {
-            int rank = i / 8;
-            int file = i % 8;
-            
-            bool isCentralSquare = (rank >= 3 && rank <= 4 && file >= 3 && file <= 4);
-            
-            bool isNearCentralSquare = (rank >= 2 && rank <= 5 && file >= 2 && file <= 5) && !isCentralSquare;
-            
-            char piece = boardState[i];
-            if (piece != ' ') {
-                bool isWhitePiece = isupper(piece);
-                
-                if (isCentralSquare) {
-                    if (isWhitePiece) {
-                        score += 25;
-                    } else {
-                        score -= 25;
-                    }
-                }
-                else if (isNearCentralSquare) {
-                    if (isWhitePiece) {
-                        score += 10;
-                    } else {
-                        score -= 10;
-                    }
-                }
-            }
-        }
+        const Bitboard centralSquares = SquareBit(27) | SquareBit(28) | SquareBit(35) | SquareBit(36);
+        const Bitboard nearCentralSquares = 0x00003C3C3C3C0000ULL & ~centralSquares;
+        Bitboard whitePieces = SidePieces(position, true);
+        Bitboard blackPieces = SidePieces(position, false);
+
+        score += (PopCount(whitePieces & centralSquares) - PopCount(blackPieces & centralSquares)) * 25;
+        score += (PopCount(whitePieces & nearCentralSquares) - PopCount(blackPieces & nearCentralSquares)) * 10;
     }
     
-    static const int pawnTable[64] = {
-        0,  0,  0,  0,  0,  0,  0,  0,
-        50, 50, 50, 50, 50, 50, 50, 50,
-        10, 10, 20, 30, 30, 20, 10, 10,
-        5,  5, 10, 25, 25, 10,  5,  5,
-        0,  0,  0, 20, 20,  0,  0,  0,
-        5, -5,-10,  0,  0,-10, -5,  5,
-        5, 10, 10,-20,-20, 10, 10,  5,
-        0,  0,  0,  0,  0,  0,  0,  0
-    };
-    
     static const int knightTable[64] = {
         -50,-40,-30,-30,-30,-30,-40,-50,
         -40,-20,  0,  0,  0,  0,-20,-40,
@@ -1468,17 +2536,6 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
          0,  0,  0,  5,  5,  0,  0,  0
     };
     
-    static const int queenTable[64] = {
-        -20,-10,-10, -5, -5,-10,-10,-20,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -10,  0,  5,  5,  5,  5,  0,-10,
-         -5,  0,  5,  5,  5,  5,  0, -5,
-          0,  0,  5,  5,  5,  5,  0, -5,
-        -10,  5,  5,  5,  5,  5,  0,-10,
-        -10,  0,  5,  0,  0,  0,  0,-10,
-        -20,-10,-10, -5, -5,-10,-10,-20
-    };
-    
     static const int kingMiddlegameTable[64] = {
         -30,-40,-40,-50,-50,-40,-40,-30,
         -30,-40,-40,-50,-50,-40,-40,-30,
@@ -1501,32 +2558,28 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         -50,-30,-30,-30,-30,-30,-30,-50
     };
     
-    for (int pawnPos : whitePawnPositions) {
-        score += pawnTable[pawnPos];
-    }
-    for (int pawnPos : blackPawnPositions) {
-        score -= pawnTable[63 - pawnPos];
-    }
+    const PawnEntry& pawns = ProbePawnTable(position);
+    score += pawns.score;
     
-    for (int knightPos : whiteKnightPositions) {
-        score += knightTable[knightPos];
+    for (Bitboard b = whiteKnightsBB; b; ) {
+        score += knightTable[PopLSB(b)];
     }
-    for (int knightPos : blackKnightPositions) {
-        score -= knightTable[63 - knightPos];
+    for (Bitboard b = blackKnightsBB; b; ) {
+        score -= knightTable[63 - PopLSB(b)];
     }
     
-    for (int bishopPos : whiteBishopPositions) {
-        score += bishopTable[bishopPos];
+    for (Bitboard b = whiteBishopsBB; b; ) {
+        score += bishopTable[PopLSB(b)];
     }
-    for (int bishopPos : blackBishopPositions) {
-        score -= bishopTable[63 - bishopPos];
+    for (Bitboard b = blackBishopsBB; b; ) {
+        score -= bishopTable[63 - PopLSB(b)];
     }
     
-    for (int rookPos : whiteRookPositions) {
-        score += rookTable[rookPos];
+    for (Bitboard b = whiteRooksBB; b; ) {
+        score += rookTable[PopLSB(b)];
     }
-    for (int rookPos : blackRookPositions) {
-        score -= rookTable[63 - rookPos];
+    for (Bitboard b = blackRooksBB; b; ) {
+        score -= rookTable[63 - PopLSB(b)];
     }
     
     if (whiteKingPos >= 0) {
@@ -1545,7 +2598,8 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         }
     }
     
-    for (int knightPos : whiteKnightPositions) {
+    for (Bitboard b = whiteKnightsBB; b; ) {
+        int knightPos = PopLSB(b);
         int file = knightPos % 8;
         int rank = knightPos / 8;
         
@@ -1556,28 +2610,12 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
             }
         }
         
-        int actualMobility = 0;
-        const std::vector<std::pair<int, int>> knightMoves = {
-            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
-            {1, -2}, {1, 2}, {2, -1}, {2, 1}
-        };
-        
-        for (const auto& move : knightMoves) {
-            int newRow = rank + move.first;
-            int newCol = file + move.second;
-            
-            if (newRow >= 0 && newRow < 8 && newCol >= 0 && newCol < 8) {
-                char targetSquare = boardState[newRow * 8 + newCol];
-                if (targetSquare == ' ' || islower(targetSquare)) {
-                    actualMobility++;
-                }
-            }
-        }
-        
+        int actualMobility = PopCount(knightAttacks[knightPos] & ~SidePieces(position, true));
         score += actualMobility * 4;
     }
     
-    for (int knightPos : blackKnightPositions) {
+    for (Bitboard b = blackKnightsBB; b; ) {
+        int knightPos = PopLSB(b);
         int file = knightPos % 8;
         int rank = knightPos / 8;
         
@@ -1588,51 +2626,28 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
             }
         }
         
-        int actualMobility = 0;
-        const std::vector<std::pair<int, int>> knightMoves = {
-            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
-            {1, -2}, {1, 2}, {2, -1}, {2, 1}
-        };
-        
-        for (const auto& move : knightMoves) {
-            int newRow = rank + move.first;
-            int newCol = file + move.second;
-            
-            if (newRow >= 0 && newRow < 8 && newCol >= 0 && newCol < 8) {
-                char targetSquare = boardState[newRow * 8 + newCol];
-                if (targetSquare == ' ' || isupper(targetSquare)) {
-                    actualMobility++;
-                }
-            }
-        }
-        
+        int actualMobility = PopCount(knightAttacks[knightPos] & ~SidePieces(position, false));
         score -= actualMobility * 4;
     }
     
-    if (whiteBishops >= 2) {
-        score += 50;
-        whiteHasBishopPair = true;
-    }
-    if (blackBishops >= 2) {
-        score -= 50;
-        blackHasBishopPair = true;
-    }
-    
-    for (int bishopPos : whiteBishopPositions) {
+    for (Bitboard b = whiteBishopsBB; b; ) {
+        int bishopPos = PopLSB(b);
         if ((bishopPos == 56 || bishopPos == 63) && 
             (boardState[bishopPos - 8] == 'P' || boardState[bishopPos - 9] == 'P' || boardState[bishopPos - 7] == 'P')) {
             score -= 100;
         }
     }
     
-    for (int bishopPos : blackBishopPositions) {
+    for (Bitboard b = blackBishopsBB; b; ) {
+        int bishopPos = PopLSB(b);
         if ((bishopPos == 0 || bishopPos == 7) && 
             (boardState[bishopPos + 8] == 'p' || boardState[bishopPos + 9] == 'p' || boardState[bishopPos + 7] == 'p')) {
             score += 100;
         }
     }
     
-    for (int knightPos : whiteKnightPositions) {
+    for (Bitboard b = whiteKnightsBB; b; ) {
+        int knightPos = PopLSB(b);
         int rank = knightPos / 8;
         int file = knightPos % 8;
         
@@ -1659,7 +2674,8 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         }
     }
     
-    for (int knightPos : blackKnightPositions) {
+    for (Bitboard b = blackKnightsBB; b; ) {
+        int knightPos = PopLSB(b);
         int rank = knightPos / 8;
         int file = knightPos % 8;
         
@@ -1686,96 +2702,48 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         }
     }
     
-    for (int file = 0; file < 8; file++) {
-        if (whitePawns[file] > 1) {
-            score -= 20 * (whitePawns[file] - 1);
-        }
-        if (blackPawns[file] > 1) {
-            score += 20 * (blackPawns[file] - 1);
-        }
+    for (Bitboard b = pawns.passedPawns[0]; b; ) {
+        int passedBonus = 20 + (7 - PopLSB(b) / 8) * 10;
+        if (gamePhase == 2) passedBonus *= 2;
+        score += passedBonus;
     }
     
-    for (int pawnPos : whitePawnPositions) {
-        int file = pawnPos % 8;
-        int rank = pawnPos / 8;
-        
-        bool isIsolated = true;
-        if (file > 0 && whitePawns[file-1] > 0) isIsolated = false;
-        if (file < 7 && whitePawns[file+1] > 0) isIsolated = false;
-        
-        if (isIsolated) {
-            score -= 15;
-        }
-        
-        bool isPassed = true;
-        for (int r = rank - 1; r >= 0; r--) {
-            for (int f = customMax(0, file-1); f <= customMin(7, file+1); f++) {
-                if (boardState[r*8+f] == 'p') {
-                    isPassed = false;
-                    break;
-                }
-            }
-            if (!isPassed) break;
-        }
-        
-        if (isPassed) {
-            int passedBonus = 20 + (7 - rank) * 10;
-            if (gamePhase == 2) passedBonus *= 2;
-            score += passedBonus;
-        }
-        
-        if (gamePhase < 2 && whiteKingPos >= 0) {
-            int kingFile = whiteKingPos % 8;
-            if (abs(file - kingFile) <= 1 && rank < 6) {
+    for (Bitboard b = pawns.passedPawns[1]; b; ) {
+        int passedBonus = 20 + (PopLSB(b) / 8) * 10;
+        if (gamePhase == 2) passedBonus *= 2;
+        score -= passedBonus;
+    }
+    
+    if (gamePhase < 2 && whiteKingPos >= 0) {
+        int kingFile = whiteKingPos % 8;
+        for (Bitboard b = whitePawnsBB; b; ) {
+            int pawnPos = PopLSB(b);
+            int rank = pawnPos / 8;
+            if (abs(pawnPos % 8 - kingFile) <= 1 && rank < 6) {
                 score -= (6 - rank) * 5;
             }
         }
     }
     
-    for (int pawnPos : blackPawnPositions) {
-        int file = pawnPos % 8;
-        int rank = pawnPos / 8;
-        
-        bool isIsolated = true;
-        if (file > 0 && blackPawns[file-1] > 0) isIsolated = false;
-        if (file < 7 && blackPawns[file+1] > 0) isIsolated = false;
-        
-        if (isIsolated) {
-            score += 15;
-        }
-        
-        bool isPassed = true;
-        for (int r = rank + 1; r < 8; r++) {
-            for (int f = customMax(0, file-1); f <= customMin(7, file+1); f++) {
-                if (boardState[r*8+f] == 'P') {
-                    isPassed = false;
-                    break;
-                }
-            }
-            if (!isPassed) break;
-        }
-        
-        if (isPassed) {
-            int passedBonus = 20 + rank * 10;
-            if (gamePhase == 2) passedBonus *= 2;
-            score -= passedBonus;
-        }
-        
-        if (gamePhase < 2 && blackKingPos >= 0) {
-            int kingFile = blackKingPos % 8;
-            if (abs(file - kingFile) <= 1 && rank > 1) {
+    if (gamePhase < 2 && blackKingPos >= 0) {
+        int kingFile = blackKingPos % 8;
+        for (Bitboard b = blackPawnsBB; b; ) {
+            int pawnPos = PopLSB(b);
+            int rank = pawnPos / 8;
+            if (abs(pawnPos % 8 - kingFile) <= 1 && rank > 1) {
                 score += (rank - 1) * 5;
             }
         }
     }
     
-    for (int rookPos : whiteRookPositions) {
+    for (Bitboard b = whiteRooksBB; b; ) {
+        int rookPos = PopLSB(b);
         int file = rookPos % 8;
         
-        if (whitePawns[file] == 0 && blackPawns[file] == 0) {
+        if ((whitePawnsBB & fileMasks[file]) == 0 && (blackPawnsBB & fileMasks[file]) == 0) {
             score += 25;
         }
-        else if (whitePawns[file] == 0) {
+        else if ((whitePawnsBB & fileMasks[file]) == 0) {
             score += 15;
         }
         
@@ -1784,13 +2752,14 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         }
     }
     
-    for (int rookPos : blackRookPositions) {
+    for (Bitboard b = blackRooksBB; b; ) {
+        int rookPos = PopLSB(b);
         int file = rookPos % 8;
         
-        if (whitePawns[file] == 0 && blackPawns[file] == 0) {
+        if ((whitePawnsBB & fileMasks[file]) == 0 && (blackPawnsBB & fileMasks[file]) == 0) {
             score -= 25;
         }
-        else if (blackPawns[file] == 0) {
+        else if ((blackPawnsBB & fileMasks[file]) == 0) {
             score -= 15;
         }
         
@@ -1844,19 +2813,9 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         if (boardState[2] == 'b') score += 10; 
         if (boardState[5] == 'b') score += 10; 
         
-        for (size_t i = 0; i < boardState.size(); i++) {
-            if (boardState[i] == 'Q' && i != 59) {
-                int moveCount = position.fullMoveNumber;
-                if (moveCount < 5) {
-                    score -= 30;
-                }
-            }
-            if (boardState[i] == 'q' && i != 3) {
-                int moveCount = position.fullMoveNumber;
-                if (moveCount < 5) {
-                    score += 30; 
-                }
-            }
+        if (position.fullMoveNumber < 5) {
+            score -= PopCount(Pieces(position, true, QUEEN) & ~SquareBit(59)) * 30;
+            score += PopCount(Pieces(position, false, QUEEN) & ~SquareBit(3)) * 30;
         }
         
         if (position.fullMoveNumber <= 2 && !position.whiteToMove) {
@@ -1879,11 +2838,8 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
     
     int whiteMobility = 0, blackMobility = 0;
     
-    std::vector<Move> whiteMoves = GenerateMoves(position, true, true);
-    std::vector<Move> blackMoves = GenerateMoves(position, false, true);
-    
-    whiteMobility = whiteMoves.size() - whiteKnightPositions.size() * 8;
-    blackMobility = blackMoves.size() - blackKnightPositions.size() * 8;
+    whiteMobility = CountMoves(position, true) - MaterialCount(position.materialKey, true, KNIGHT) * 8;
+    blackMobility = CountMoves(position, false) - MaterialCount(position.materialKey, false, KNIGHT) * 8;
     
     if (gamePhase == 0) {
         score += whiteMobility * 2;
@@ -1903,29 +2859,30 @@ int EvaluateBoard(const BoardPosition& position, int searchDepth) {
         score -= 50;
     }
 
+    score = score * material.scale[score > 0 ? 0 : 1] / SCALE_NORMAL;
+
     if (currentPersonality != STANDARD) {
         bool useFullPersonality = (searchDepth <= 2);
         
-        std::vector<Move>* movesToPass = nullptr;
+        MoveList* movesToPass = nullptr;
         if (useFullPersonality && (currentPersonality == AGGRESSIVE || currentPersonality == DYNAMIC)) {
-            static std::vector<Move> currentMoves;
-            currentMoves = GenerateMoves(position, position.whiteToMove);
+            thread_local MoveList currentMoves;
+            currentMoves.clear();
+            GenerateMoves(position, position.whiteToMove, currentMoves);
             movesToPass = &currentMoves;
         }
         
         score = ApplyPersonalityToEvaluation(score, position, movesToPass, useFullPersonality);
     }
 
-    if (evaluationCache.size() < MAX_EVAL_CACHE_SIZE) {
-        evaluationCache[key] = score;
-    }
+    StoreEvalCache(key, score);
 
     return score;
 }
 
 BoardPosition ParseMoveHistory(const std::string& moveHistory) {
     BoardPosition position;
-    position.boardState = "rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR";
+    SetupBoard(position, "rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR");
     position.whiteCanCastleKingside = true;
     position.whiteCanCastleQueenside = true;
     position.blackCanCastleKingside = true;
@@ -1934,6 +2891,7 @@ BoardPosition ParseMoveHistory(const std::string& moveHistory) {
     position.halfMoveClock = 0;
     position.fullMoveNumber = 1;
     position.whiteToMove = true;
+    position.hash = ComputeZobristKey(position);
     
     if (moveHistory.empty()) {
         return position;
@@ -1965,33 +2923,33 @@ BoardPosition ApplyAlgebraicMove(const BoardPosition& position, const std::strin
     
     if (algebraicMove == "O-O" || algebraicMove == "0-0") {
         if (position.whiteToMove) {
-            newPosition.boardState[60] = ' ';
-            newPosition.boardState[62] = 'K';
-            newPosition.boardState[63] = ' ';
-            newPosition.boardState[61] = 'R';
+            RemovePiece(newPosition, 60);
+            PutPiece(newPosition, 62, 'K');
+            RemovePiece(newPosition, 63);
+            PutPiece(newPosition, 61, 'R');
             newPosition.whiteCanCastleKingside = false;
             newPosition.whiteCanCastleQueenside = false;
         } else {
-            newPosition.boardState[4] = ' ';
-            newPosition.boardState[6] = 'k';
-            newPosition.boardState[7] = ' ';
-            newPosition.boardState[5] = 'r';
+            RemovePiece(newPosition, 4);
+            PutPiece(newPosition, 6, 'k');
+            RemovePiece(newPosition, 7);
+            PutPiece(newPosition, 5, 'r');
             newPosition.blackCanCastleKingside = false;
             newPosition.blackCanCastleQueenside = false;
         }
     } else if (algebraicMove == "O-O-O" || algebraicMove == "0-0-0") {
         if (position.whiteToMove) {
-            newPosition.boardState[60] = ' ';
-            newPosition.boardState[58] = 'K';
-            newPosition.boardState[56] = ' ';
-            newPosition.boardState[59] = 'R';
+            RemovePiece(newPosition, 60);
+            PutPiece(newPosition, 58, 'K');
+            RemovePiece(newPosition, 56);
+            PutPiece(newPosition, 59, 'R');
             newPosition.whiteCanCastleKingside = false;
             newPosition.whiteCanCastleQueenside = false;
         } else {
-            newPosition.boardState[4] = ' ';
-            newPosition.boardState[2] = 'k';
-            newPosition.boardState[0] = ' ';
-            newPosition.boardState[3] = 'r';
+            RemovePiece(newPosition, 4);
+            PutPiece(newPosition, 2, 'k');
+            RemovePiece(newPosition, 0);
+            PutPiece(newPosition, 3, 'r');
             newPosition.blackCanCastleKingside = false;
             newPosition.blackCanCastleQueenside = false;
         }
@@ -2036,12 +2994,11 @@ BoardPosition ApplyAlgebraicMove(const BoardPosition& position, const std::strin
             
             char searchPiece = position.whiteToMove ? movingPiece : tolower(movingPiece);
             
-            std::vector<Move> possibleMoves = GenerateMoves(position, position.whiteToMove);
+            MoveList possibleMoves;
+            GenerateMoves(position, position.whiteToMove, possibleMoves);
             for (const Move& move : possibleMoves) {
-                int endPos = std::stoi(move.notation.substr(3, 2));
-                if (endPos == toSquare && move.notation[0] == searchPiece) {
-                    int fromPos = std::stoi(move.notation.substr(1, 2));
-                    from = IndexToAlgebraic(fromPos);
+                if (move.To() == toSquare && position.boardState[move.From()] == searchPiece) {
+                    from = IndexToAlgebraic(move.From());
                     break;
                 }
             }
@@ -2066,18 +3023,22 @@ BoardPosition ApplyAlgebraicMove(const BoardPosition& position, const std::strin
             }
         }
         
-        newPosition.boardState[toIndex] = position.boardState[fromIndex];
-        newPosition.boardState[fromIndex] = ' ';
+        RemovePiece(newPosition, toIndex);
+        RemovePiece(newPosition, fromIndex);
+        if (position.boardState[fromIndex] != ' ') {
+            PutPiece(newPosition, toIndex, position.boardState[fromIndex]);
+        }
         
         if (isEnPassant && enPassantCapturePos >= 0) {
-            newPosition.boardState[enPassantCapturePos] = ' ';
+            RemovePiece(newPosition, enPassantCapturePos);
         }
         
-        if (promotionPiece != '\0') {
+        if (promotionPiece != '\0' && PieceTypeOf(promotionPiece) != NO_PIECE_TYPE) {
+            RemovePiece(newPosition, toIndex);
             if (position.whiteToMove) {
-                newPosition.boardState[toIndex] = toupper(promotionPiece);
+                PutPiece(newPosition, toIndex, toupper(promotionPiece));
             } else {
-                newPosition.boardState[toIndex] = tolower(promotionPiece);
+                PutPiece(newPosition, toIndex, tolower(promotionPiece));
             }
         }
         
@@ -2126,6 +3087,7 @@ BoardPosition ApplyAlgebraicMove(const BoardPosition& position, const std::strin
     if (!position.whiteToMove) {
         newPosition.fullMoveNumber++;
     }
+    newPosition.hash = ComputeZobristKey(newPosition);
     
     return newPosition;
 }
@@ -2142,25 +3104,17 @@ int AlgebraicToIndex(const std::string& algebraic) {
 }
 
 std::string ConvertToAlgebraic(const Move& move, const BoardPosition& position) {
-    if (move.notation.length() < 5) {
+    if (move.IsNull()) {
         return "error";
     }
     
-    int startPos;
-    int endPos;
-    
-    try {
-        startPos = std::stoi(move.notation.substr(1, move.notation.length() > 3 ? move.notation.length() - 3 : 1));
-        endPos = std::stoi(move.notation.substr(move.notation.length() - 2, 2));
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing move notation: " << move.notation << " - " << e.what() << std::endl;
-        return "error";
-    }
+    int startPos = move.From();
+    int endPos = move.To();
 
     std::string startSquare = IndexToAlgebraic(startPos);
     std::string endSquare = IndexToAlgebraic(endPos);
 
-    char piece = !move.notation.empty() ? move.notation[0] : 'P';
+    char piece = position.boardState[startPos] != ' ' ? position.boardState[startPos] : 'P';
     bool isWhite = isupper(piece);
 
     char target = position.boardState[endPos];
@@ -2168,7 +3122,7 @@ std::string ConvertToAlgebraic(const Move& move, const BoardPosition& position)
         ((isWhite && islower(target)) ||
             (!isWhite && isupper(target))));
 
-    bool isCapture = isOpponentPiece || move.isEnPassant;
+    bool isCapture = isOpponentPiece || move.IsEnPassant();
 
     std::string algebraic;
 
@@ -2184,6 +3138,10 @@ std::string ConvertToAlgebraic(const Move& move, const BoardPosition& position)
 
     algebraic += endSquare;
 
+    if (move.IsPromotion()) {
+        algebraic += PieceChar(move.Promotion(), false);
+    }
+
     return algebraic;
 }
 
@@ -2198,10 +3156,10 @@ std::string IndexToAlgebraic(int index) {
     return result;
 }
 
-void PrintBoard(const std::string& boardState) {
+void PrintBoard(const BoardPosition& position) {
     for (int r = 0; r < 8; ++r) {
         for (int c = 0; c < 8; ++c) {
-            std::cout << boardState[r * 8 + c] << ' ';
+            std::cout << position.boardState[r * 8 + c] << ' ';
         }
         std::cout << std::endl;
     }
@@ -2213,18 +3171,10 @@ Move AlgebraicToInternalMove(const std::string& algebraicMove, const BoardPositi
     }
     
     if (algebraicMove == "O-O" || algebraicMove == "0-0") {
-        Move move;
-        move.isCastling = true;
-        move.isKingsideCastling = true;
-        move.notation = (position.whiteToMove ? "K" : "k") + std::string(position.whiteToMove ? "6062" : "0406");
-        return move;
+        return position.whiteToMove ? Move(60, 62, CASTLING) : Move(4, 6, CASTLING);
     }
     if (algebraicMove == "O-O-O" || algebraicMove == "0-0-0") {
-        Move move;
-        move.isCastling = true;
-        move.isKingsideCastling = false;
-        move.notation = (position.whiteToMove ? "K" : "k") + std::string(position.whiteToMove ? "6058" : "0402");
-        return move;
+        return position.whiteToMove ? Move(60, 58, CASTLING) : Move(4, 2, CASTLING);
     }
 
     std::string moveWithoutCapture = algebraicMove;
@@ -2244,12 +3194,11 @@ Move AlgebraicToInternalMove(const std::string& algebraicMove, const BoardPositi
             int fromIndex = AlgebraicToIndex(from);
             int toIndex = AlgebraicToIndex(to);
             
-            Move move;
-            std::string startPosStr = (fromIndex < 10) ? "0" + std::to_string(fromIndex) : std::to_string(fromIndex);
-            std::string endPosStr = (toIndex < 10) ? "0" + std::to_string(toIndex) : std::to_string(toIndex);
-            move.notation = piece + startPosStr + endPosStr;
+            if (toupper(piece) == 'K' && abs(fromIndex - toIndex) == 2) {
+                return Move(fromIndex, toIndex, CASTLING);
+            }
             
-            return move;
+            return Move(fromIndex, toIndex);
         } catch (const std::exception& e) {
             throw std::invalid_argument("Error parsing piece notation: " + algebraicMove + " - " + e.what());
         }
@@ -2268,24 +3217,22 @@ Move AlgebraicToInternalMove(const std::string& algebraicMove, const BoardPositi
                 piece = position.whiteToMove ? 'P' : 'p';
             }
             
-            Move move;
-            std::string startPosStr = (fromIndex < 10) ? "0" + std::to_string(fromIndex) : std::to_string(fromIndex);
-            std::string endPosStr = (toIndex < 10) ? "0" + std::to_string(toIndex) : std::to_string(toIndex);
-            move.notation = piece + startPosStr + endPosStr;
-            
             if (tolower(piece) == 'p' && (fromIndex % 8) != (toIndex % 8) && position.boardState[toIndex] == ' ') {
-                move.isEnPassant = true;
-                move.enPassantCapturePos = position.whiteToMove ? (toIndex + 8) : (toIndex - 8);
+                return Move(fromIndex, toIndex, EN_PASSANT);
+            }
+            
+            if (tolower(piece) == 'k' && abs(fromIndex - toIndex) == 2) {
+                return Move(fromIndex, toIndex, CASTLING);
             }
             
-            if (algebraicMove.length() > 4) {
-                char promotionPiece = algebraicMove[4];
-                if (isalpha(promotionPiece)) {
-                    move.notation += promotionPiece;
+            if (tolower(piece) == 'p' && moveWithoutCapture.length() > 4) {
+                int promotion = PieceTypeOf(moveWithoutCapture[4]);
+                if (promotion >= KNIGHT && promotion <= QUEEN) {
+                    return Move(fromIndex, toIndex, PROMOTION, promotion);
                 }
             }
             
-            return move;
+            return Move(fromIndex, toIndex);
         } catch (const std::exception& e) {
             throw std::invalid_argument("Error parsing coordinate notation: " + algebraicMove + " - " + e.what());
         }
@@ -2296,7 +3243,7 @@ Move AlgebraicToInternalMove(const std::string& algebraicMove, const BoardPositi
 
 int EvaluateOpeningPrinciples(const BoardPosition& position) {
    int score = 0;
-    const std::string& boardState = position.boardState;
+    const char* boardState = position.boardState;
     int moveNum = position.fullMoveNumber;
 
     if (moveNum == 1 && position.whiteToMove) {
@@ -2506,10 +3453,10 @@ int EvaluateOpeningPrinciples(const BoardPosition& position) {
 }
 
 int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position, 
-                               const std::vector<Move>* preCalculatedMoves,
+                               const MoveList* preCalculatedMoves,
                                bool fullCalculation) {
     int score = baseScore;
-    const std::string& boardState = position.boardState;
+    const char* boardState = position.boardState;
     
     int whitePieceCount = 0, blackPieceCount = 0;
     int whiteCentralPieces = 0, blackCentralPieces = 0;
@@ -2549,8 +3496,9 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
             }
         }
         
-        whitePawnStructureScore = EvaluatePawnStructure(position, true);
-        blackPawnStructureScore = EvaluatePawnStructure(position, false);
+        const PawnEntry& pawns = ProbePawnTable(position);
+        whitePawnStructureScore = pawns.structureScore[0];
+        blackPawnStructureScore = pawns.structureScore[1];
     }
 
     const int PERSONALITY_FACTOR = 20;
@@ -2571,11 +3519,10 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
                 
                 if (preCalculatedMoves) {
                     for (const Move& move : *preCalculatedMoves) {
-                        if (move.notation.length() >= 5) {
-                            int endPos = std::stoi(move.notation.substr(3, 2));
-                            char target = position.boardState[endPos];
+                        if (!move.IsNull()) {
+                            char target = position.boardState[move.To()];
                             if (target != ' ') {
-                                int attackerValue = GetPieceValue(move.notation[0]);
+                                int attackerValue = GetPieceValue(position.boardState[move.From()]);
                                 int targetValue = GetPieceValue(target);
                                 
                                 if (targetValue * 1.5 >= attackerValue) {
@@ -2630,12 +3577,8 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
                 score += whitePawnStructureScore * 3 * PERSONALITY_FACTOR;
                 score -= blackPawnStructureScore * 3 * PERSONALITY_FACTOR;
                 
-                for (int i = 0; i < 64; i++) {
-                    if (boardState[i] == 'B') score += 50 * PERSONALITY_FACTOR;
-                    if (boardState[i] == 'b') score -= 50 * PERSONALITY_FACTOR;
-                    if (boardState[i] == 'N') score += 30 * PERSONALITY_FACTOR;
-                    if (boardState[i] == 'n') score -= 30 * PERSONALITY_FACTOR;
-                }
+                score += (PopCount(Pieces(position, true, BISHOP)) - PopCount(Pieces(position, false, BISHOP))) * 50 * PERSONALITY_FACTOR;
+                score += (PopCount(Pieces(position, true, KNIGHT)) - PopCount(Pieces(position, false, KNIGHT))) * 30 * PERSONALITY_FACTOR;
                 
                 int whiteCoordination = 0, blackCoordination = 0;
                 for (int i = 0; i < 64; i++) {
@@ -2684,12 +3627,8 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
                     }
                 }
                 
-                for (int i = 0; i < 64; i++) {
-                    if (boardState[i] == 'N') score += 60 * PERSONALITY_FACTOR;
-                    if (boardState[i] == 'n') score -= 60 * PERSONALITY_FACTOR;
-                    if (boardState[i] == 'B') score += 40 * PERSONALITY_FACTOR;
-                    if (boardState[i] == 'b') score -= 40 * PERSONALITY_FACTOR;
-                }
+                score += (PopCount(Pieces(position, true, KNIGHT)) - PopCount(Pieces(position, false, KNIGHT))) * 60 * PERSONALITY_FACTOR;
+                score += (PopCount(Pieces(position, true, BISHOP)) - PopCount(Pieces(position, false, BISHOP))) * 40 * PERSONALITY_FACTOR;
                 
                 score -= whiteAttackingPieces * 75 * PERSONALITY_FACTOR;
                 score += blackAttackingPieces * 75 * PERSONALITY_FACTOR;
@@ -2714,11 +3653,10 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
                 
                 if (preCalculatedMoves) {
                     for (const Move& move : *preCalculatedMoves) {
-                        if (move.notation.length() >= 5) {
-                            int endPos = std::stoi(move.notation.substr(3, 2));
-                            char target = position.boardState[endPos];
+                        if (!move.IsNull()) {
+                            char target = position.boardState[move.To()];
                             if (target != ' ') {
-                                int attackerValue = GetPieceValue(move.notation[0]);
+                                int attackerValue = GetPieceValue(position.boardState[move.From()]);
                                 int targetValue = GetPieceValue(target);
                                 
                                 if (targetValue >= attackerValue) {
@@ -2730,12 +3668,7 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
                     }
                 }
                 
-                int pieceCount = 0;
-                for (int i = 0; i < 64; i++) {
-                    if (boardState[i] != ' ' && tolower(boardState[i]) != 'p') {
-                        pieceCount++;
-                    }
-                }
+                int pieceCount = PopCount(position.occupied & ~(Pieces(position, true, PAWN) | Pieces(position, false, PAWN)));
                 isEndgameNear = (pieceCount <= 12);
                 
                 if (hasTacticalOpportunities) {
@@ -2747,29 +3680,22 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
                     std::cout << "DINAMIC: Stil pozițional pentru poziție deschisă" << std::endl;
                     score += (whiteCentralPieces - blackCentralPieces) * 160 * PERSONALITY_FACTOR;
                     
-                    for (int i = 0; i < 64; i++) {
-                        if (boardState[i] == 'B') score += 70 * PERSONALITY_FACTOR;
-                        if (boardState[i] == 'b') score -= 70 * PERSONALITY_FACTOR;
-                    }
+                    score += (PopCount(Pieces(position, true, BISHOP)) - PopCount(Pieces(position, false, BISHOP))) * 70 * PERSONALITY_FACTOR;
                 }
                 else if (!isOpenPosition) {
                     std::cout << "DINAMIC: Stil solid pentru poziție închisă" << std::endl;
                     score += whitePieceCount * 55 * PERSONALITY_FACTOR;
                     score -= blackPieceCount * 55 * PERSONALITY_FACTOR;
                     
-                    for (int i = 0; i < 64; i++) {
-                        if (boardState[i] == 'N') score += 80 * PERSONALITY_FACTOR;
-                        if (boardState[i] == 'n') score -= 80 * PERSONALITY_FACTOR;
-                    }
+                    score += (PopCount(Pieces(position, true, KNIGHT)) - PopCount(Pieces(position, false, KNIGHT))) * 80 * PERSONALITY_FACTOR;
                 }
                 else if (isEndgameNear) {
                     std::cout << "DINAMIC: Stil de final" << std::endl;
                     
-                    int whiteKingPos = -1, blackKingPos = -1;
-                    for (int i = 0; i < 64; i++) {
-                        if (boardState[i] == 'K') whiteKingPos = i;
-                        else if (boardState[i] == 'k') blackKingPos = i;
-                    }
+                    Bitboard whiteKing = Pieces(position, true, KING);
+                    Bitboard blackKing = Pieces(position, false, KING);
+                    int whiteKingPos = whiteKing ? LSB(whiteKing) : -1;
+                    int blackKingPos = blackKing ? LSB(blackKing) : -1;
                     
                     if (whiteKingPos >= 0 && blackKingPos >= 0) {
                         int whiteKingRank = whiteKingPos / 8;
@@ -2801,73 +3727,96 @@ int ApplyPersonalityToEvaluation(int baseScore, const BoardPosition& position,
     return score;
 }
 
-bool IsMoveSafe(const BoardPosition& position, const Move& move) {
-    int endPos = std::stoi(move.notation.substr(3, 2));
-    bool isCapture = (position.boardState[endPos] != ' ' || move.isEnPassant);
+// Pool tasks pass a diagnostic string so their lines can be printed in move order afterwards
+void ReportDiagnostic(const std::string& message, std::string* diagnostic) {
+    if (diagnostic != nullptr) {
+        *diagnostic = message;
+    } else {
+        std::cout << message << std::endl;
+    }
+}
+
+bool IsMoveSafe(BoardPosition& position, const Move& move, std::string* diagnostic) {
+    int endPos = move.To();
+    bool isCapture = (position.boardState[endPos] != ' ' || move.IsEnPassant());
     
     if (isCapture) {
         return IsGoodCapture(position, move);
     }
     
-    BoardPosition newPosition = ApplyMove(position, move);
+    bool isWhite = position.whiteToMove;
+    int recapturerValue = 0;
+    bool canBeCaptured = false;
+    
+    MakeMove(position, move);
     
-    char movedPiece = newPosition.boardState[endPos];
+    char movedPiece = position.boardState[endPos];
     int movedValue = GetPieceValue(movedPiece);
     
-    std::vector<Move> responses = GenerateMoves(newPosition, !position.whiteToMove);
+    MoveList responses;
+    GenerateMoves(position, !isWhite, responses);
     
     for (const Move& response : responses) {
-        int responseTarget = std::stoi(response.notation.substr(3, 2));
-        
-        if (responseTarget == endPos) {
-            char recapturer = response.notation[0];
-            int recapturerValue = GetPieceValue(recapturer);
+        if (response.To() == endPos) {
+            char recapturer = position.boardState[response.From()];
+            recapturerValue = GetPieceValue(recapturer);
             
             if (recapturerValue < movedValue) {
-                std::string attackerType = (recapturerValue == 1) ? "pawn" : 
-                                          (recapturerValue == 3) ? "minor piece" : 
-                                          (recapturerValue == 5) ? "rook" : "queen";
-                
-                std::cout << "UNSAFE MOVE DETECTED: " << ConvertToAlgebraic(move, position) 
-                          << " can be captured by " << attackerType 
-                          << " (" << recapturerValue << " vs " << movedValue << ")" << std::endl;
-                return false;
+                canBeCaptured = true;
+                break;
             }
         }
     }
     
+    UnmakeMove(position);
+    
+    if (canBeCaptured) {
+        std::string attackerType = (recapturerValue == 1) ? "pawn" : 
+                                  (recapturerValue == 3) ? "minor piece" : 
+                                  (recapturerValue == 5) ? "rook" : "queen";
+        
+        if (searchThreadIndex == 0) {
+            std::ostringstream message;
+            message << "UNSAFE MOVE DETECTED: " << ConvertToAlgebraic(move, position) 
+                    << " can be captured by " << attackerType 
+                    << " (" << recapturerValue << " vs " << movedValue << ")";
+            ReportDiagnostic(message.str(), diagnostic);
+        }
+        return false;
+    }
+    
     return true;
 }
 
 bool IsValidMoveNotation(const Move& move) {
-    return (move.notation.length() >= 5 && 
-            isalpha(move.notation[0]) && 
-            isdigit(move.notation[1]) && 
-            isdigit(move.notation[3]));
+    return move.From() != move.To();
 }
 
-bool IsTacticalBlunder(const BoardPosition& position, const Move& move) {
-    if (move.notation.length() < 5) return false;
+bool IsTacticalBlunder(BoardPosition& position, const Move& move, std::string* diagnostic) {
+    if (move.IsNull()) return false;
     
-    int startPos = std::stoi(move.notation.substr(1, 2));
-    int endPos = std::stoi(move.notation.substr(3, 2));
+    int startPos = move.From();
+    int endPos = move.To();
     char attacker = position.boardState[startPos];
     char victim = position.boardState[endPos];
-    bool isCapture = (victim != ' ' || move.isEnPassant);
+    bool isCapture = (victim != ' ' || move.IsEnPassant());
     
     if (!isCapture) return false;
     
     int attackerValue = GetPieceValue(attacker);
-    int victimValue = move.isEnPassant ? 1 : GetPieceValue(victim);
     
-    BoardPosition afterMove = ApplyMove(position, move);
+    bool isWhite = position.whiteToMove;
     
-    int cheapestAttacker = GetCheapestAttackerValue(afterMove, endPos, !position.whiteToMove);
+    MakeMove(position, move);
+    int cheapestAttacker = GetCheapestAttackerValue(position, endPos, !isWhite);
+    UnmakeMove(position);
     
     if (cheapestAttacker > 0 && cheapestAttacker <= attackerValue) {
-        std::cout << "BLUNDER TACTIC detectat: " << ConvertToAlgebraic(move, position) 
-                  << " - piesa " << attacker << " (valoare " << attackerValue 
-                  << ") va fi recapturată de o piesă de valoare " << cheapestAttacker << std::endl;
+        std::ostringstream message;
+        message << "BLUNDER TACTIC detectat: " << ConvertToAlgebraic(move, position) 
+                << " - piesa " << attacker << " (valoare " << attackerValue 
+                << ") va fi recapturată de o piesă de valoare " << cheapestAttacker;
+        ReportDiagnostic(message.str(), diagnostic);
         return true;
     }
     
@@ -2876,7 +3825,7 @@ bool IsTacticalBlunder(const BoardPosition& position, const Move& move) {
         endPos == 36) {
         
         if (IsSquareAttacked(position, endPos, position.whiteToMove)) {
-            std::cout << "BLUNDER OPENING: Capturarea pionului apărat de pe e4 cu piesa minoră!" << std::endl;
+            ReportDiagnostic("BLUNDER OPENING: Capturarea pionului apărat de pe e4 cu piesa minoră!", diagnostic);
             return true;
         }
     }
@@ -2884,11 +3833,27 @@ bool IsTacticalBlunder(const BoardPosition& position, const Move& move) {
     return false;
 }
 
-int GetCentralityScore(const Move& move, bool isEarlyGame) {
-    if (move.notation.length() < 5) return 0;
+int CountProtectedPieces(BoardPosition& position, const Move& move) {
+    bool isWhite = position.whiteToMove;
+    int protectionCount = 0;
+    
+    MakeMove(position, move);
+    Bitboard ownPieces = SidePieces(position, isWhite) & ~SquareBit(move.To());
+    while (ownPieces) {
+        if (IsSquareAttacked(position, PopLSB(ownPieces), isWhite)) {
+            protectionCount++;
+        }
+    }
+    UnmakeMove(position);
+    
+    return protectionCount;
+}
+
+int GetCentralityScore(const BoardPosition& position, const Move& move, bool isEarlyGame) {
+    if (move.IsNull()) return 0;
     
-    int startPos = std::stoi(move.notation.substr(1, 2));
-    int endPos = std::stoi(move.notation.substr(3, 2));
+    int startPos = move.From();
+    int endPos = move.To();
     int startRank = startPos / 8;
     int startFile = startPos % 8;
     int endRank = endPos / 8;
@@ -2902,100 +3867,411 @@ int GetCentralityScore(const Move& move, bool isEarlyGame) {
     
     int developmentFactor = 0;
     if (isEarlyGame) {
-        char piece = move.notation[0];
+        char piece = position.boardState[startPos];
         
         if ((isupper(piece) && endRank == 7) || (!isupper(piece) && endRank == 0)) {
             developmentFactor = -30;
         }
     }
-    
-    int multiplier = isEarlyGame ? 10 : 2;
-    int centralityImprovement = (endCentrality - startCentrality) * multiplier;
-    
-    return centralityImprovement + developmentFactor;
-}
+    
+    int multiplier = isEarlyGame ? 10 : 2;
+    int centralityImprovement = (endCentrality - startCentrality) * multiplier;
+    
+    return centralityImprovement + developmentFactor;
+}
+
+int EvaluatePawnStructure(const BoardPosition& position, bool forWhite) {
+    int score = 0;
+    const char* boardState = position.boardState;
+    
+    int pawnsOnFile[8] = {0};
+    
+    char pawnChar = forWhite ? 'P' : 'p';
+    Bitboard pawns = Pieces(position, forWhite, PAWN);
+    Bitboard enemyPawns = Pieces(position, !forWhite, PAWN);
+    
+    while (pawns) {
+        int i = PopLSB(pawns);
+        int file = i % 8;
+        int rank = i / 8;
+        pawnsOnFile[file]++;
+        
+        int advanceRank = forWhite ? (7 - rank) : rank;
+        score += advanceRank * 5;
+        
+        bool isIsolated = true;
+        if (file > 0 && pawnsOnFile[file-1] > 0) isIsolated = false;
+        if (file < 7 && pawnsOnFile[file+1] > 0) isIsolated = false;
+        
+        if (isIsolated) {
+            score -= 15;
+        }
+        
+        if (pawnsOnFile[file] > 1) {
+            score -= 10 * (pawnsOnFile[file] - 1);
+        }
+        
+        bool isBackward = true;
+        int nextRank = forWhite ? (rank - 1) : (rank + 1);
+        if (nextRank >= 0 && nextRank < 8) {
+            for (int f = customMax(0, file-1); f <= customMin(7, file+1); f++) {
+                int checkPos = nextRank * 8 + f;
+                if (boardState[checkPos] == pawnChar) {
+                    isBackward = false;
+                    break;
+                }
+            }
+        }
+        
+        if (isBackward) {
+            score -= 12;
+        }
+        
+        bool isPassed = (passedPawnMasks[SideIndex(forWhite)][i] & enemyPawns) == 0;
+        
+        if (isPassed) {
+            int passedBonus = 10 + (forWhite ? (7 - rank) : rank) * 10;
+            score += passedBonus;
+        }
+    }
+    
+    return score;
+}
+
+// --- Start of Thread Pool --- \\
+
+// Runs independent per-root-move analyses; workers pop from the front of their own queue and steal from the back of the others
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threadCount) :
+        queueCount(customMax(1, threadCount)), queues(new TaskQueue[customMax(1, threadCount)]) {
+        for (int i = 1; i < queueCount; i++) {
+            workers.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int Size() const { return queueCount; }
+
+    // The calling thread works through queue 0 and returns once body has run for every index;
+    // the first exception thrown by body is rethrown here after the rest of the tasks finish
+    void ParallelFor(int count, const std::function<void(int)>& body) {
+        if (count <= 0) return;
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            job = &body;
+            pending = count;
+            for (int i = 0; i < count; i++) {
+                TaskQueue& queue = queues[i % queueCount];
+                std::lock_guard<std::mutex> queueLock(queue.mutex);
+                queue.tasks.push_back(i);
+            }
+            jobGeneration++;
+        }
+        wake.notify_all();
+
+        RunTasks(0);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            done.wait(lock, [this] { return pending.load() == 0; });
+            std::swap(error, jobError);
+        }
+        if (error) std::rethrow_exception(error);
+    }
 
-int EvaluatePawnStructure(const BoardPosition& position, bool forWhite) {
-    int score = 0;
-    const std::string& boardState = position.boardState;
-    
-    int pawnsOnFile[8] = {0};
-    
-    char pawnChar = forWhite ? 'P' : 'p';
-    
-    for (int i = 0; i < 64; i++) {
-        if (boardState[i] == pawnChar) {
-            int file = i % 8;
-            int rank = i / 8;
-            pawnsOnFile[file]++;
-            
-            int advanceRank = forWhite ? (7 - rank) : rank;
-            score += advanceRank * 5;
-            
-            bool isIsolated = true;
-            if (file > 0 && pawnsOnFile[file-1] > 0) isIsolated = false;
-            if (file < 7 && pawnsOnFile[file+1] > 0) isIsolated = false;
-            
-            if (isIsolated) {
-                score -= 15;
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    int queueCount;
+    std::unique_ptr<TaskQueue[]> queues;
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* job = nullptr;
+    std::atomic<int> pending{0};
+    std::exception_ptr jobError;
+    uint64_t jobGeneration = 0;
+    bool stopping = false;
+
+    bool PopTask(int self, int& task) {
+        {
+            TaskQueue& own = queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = own.tasks.front();
+                own.tasks.pop_front();
+                return true;
             }
-            
-            if (pawnsOnFile[file] > 1) {
-                score -= 10 * (pawnsOnFile[file] - 1);
+        }
+        for (int offset = 1; offset < queueCount; offset++) {
+            TaskQueue& victim = queues[(self + offset) % queueCount];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
             }
-            
-            bool isBackward = true;
-            int nextRank = forWhite ? (rank - 1) : (rank + 1);
-            if (nextRank >= 0 && nextRank < 8) {
-                for (int f = max(0, file-1); f <= min(7, file+1); f++) {
-                    int checkPos = nextRank * 8 + f;
-                    if (boardState[checkPos] == pawnChar) {
-                        isBackward = false;
-                        break;
-                    }
-                }
+        }
+        return false;
+    }
+
+    void RunTasks(int self) {
+        int task;
+        while (PopTask(self, task)) {
+            try {
+                (*job)(task);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                if (!jobError) jobError = std::current_exception();
             }
-            
-            if (isBackward) {
-                score -= 12;
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                done.notify_all();
             }
-            
-            if (file > 0 && rank > 0 && boardState[(rank-1)*8 + (file-1)] == pawnChar) {
+        }
+    }
+
+    void WorkerLoop(int self) {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                wake.wait(lock, [&] { return stopping || jobGeneration != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = jobGeneration;
             }
-            
-            bool isPassed = true;
-            int startRank = forWhite ? (rank - 1) : (rank + 1);
-            int endRank = forWhite ? 0 : 7;
-            
-            for (int r = startRank; forWhite ? (r >= endRank) : (r <= endRank); forWhite ? r-- : r++) {
-                if (r < 0 || r >= 8) continue;
-                
-                for (int f = max(0, file-1); f <= min(7, file+1); f++) {
-                    char piece = boardState[r*8 + f];
-                    if (piece == (forWhite ? 'p' : 'P')) {
-                        isPassed = false;
-                        break;
-                    }
-                }
-                if (!isPassed) break;
+            RunTasks(self);
+        }
+    }
+};
+
+// Sized by SetThreadCount. The live pool is deliberately leaked at exit, since joining threads during DLL unload
+// deadlocks on Windows; a pool replaced after a thread-count change is deleted here, on the searching thread
+WorkStealingPool* analysisPool = nullptr;
+
+WorkStealingPool& AnalysisPool() {
+    if (!analysisPool || analysisPool->Size() != searchThreadCount) {
+        delete analysisPool;
+        analysisPool = new WorkStealingPool(searchThreadCount);
+    }
+    return *analysisPool;
+}
+
+// --- End of Thread Pool --- \\
+
+const int ASPIRATION_WINDOW = 50;
+
+// PVS over the root moves in their current order; rootScores gets each move's score, or its bound when it failed
+int SearchRoot(BoardPosition& position, const std::vector<Move>& rootMoves, std::vector<int>& rootScores,
+               int depth, int alpha, int beta, Move& bestMove) {
+    int bestValue = -INFINITE_SCORE;
+
+    // The root's own static eval, so the ply-2 improving test has something to compare against
+    int rootEval = NO_EVAL;
+    if (!IsKingInCheck(position, position.whiteToMove)) {
+        rootEval = EvaluateBoard(position, depth);
+        if (!position.whiteToMove) rootEval = -rootEval;
+    }
+    staticEvalStack[undoDepth] = rootEval;
+
+    for (int i = 0; i < (int)rootMoves.size(); i++) {
+        int score;
+        MakeMove(position, rootMoves[i]);
+        if (i == 0) {
+            score = -Negamax(position, depth - 1, -beta, -alpha, position.whiteToMove, true);
+        } else {
+            score = -Negamax(position, depth - 1, -alpha - 1, -alpha, position.whiteToMove, false);
+            if (score > alpha && score < beta) {
+                score = -Negamax(position, depth - 1, -beta, -alpha, position.whiteToMove, true);
             }
-            
-            if (isPassed) {
-                int passedBonus = 10 + (forWhite ? (7 - rank) : rank) * 10;
-                score += passedBonus;
+        }
+        UnmakeMove(position);
+
+        rootScores[i] = score;
+        if (score > bestValue) {
+            bestValue = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = rootMoves[i];
+                if (alpha >= beta) break;
             }
         }
     }
-    
+
+    return bestValue;
+}
+
+// Searches a window around the previous iteration's score, widening the side that fails, then sorts the root moves by score
+int AspirationSearch(BoardPosition& position, std::vector<Move>& rootMoves, int depth, int previousScore, Move& bestMove) {
+    std::vector<int> rootScores(rootMoves.size(), -INFINITE_SCORE);
+    bool useWindow = depth > 1 && previousScore > -90000 && previousScore < 90000;
+    int window = ASPIRATION_WINDOW;
+    int alpha = useWindow ? previousScore - window : -INFINITE_SCORE;
+    int beta = useWindow ? previousScore + window : INFINITE_SCORE;
+    int score;
+
+    while (true) {
+        score = SearchRoot(position, rootMoves, rootScores, depth, alpha, beta, bestMove);
+
+        if (score <= alpha && alpha > -INFINITE_SCORE) {
+            window *= 4;
+            alpha = window > 4 * 4 * ASPIRATION_WINDOW ? -INFINITE_SCORE : customMax(previousScore - window, -INFINITE_SCORE);
+        } else if (score >= beta && beta < INFINITE_SCORE) {
+            window *= 4;
+            beta = window > 4 * 4 * ASPIRATION_WINDOW ? INFINITE_SCORE : customMin(previousScore + window, INFINITE_SCORE);
+        } else {
+            break;
+        }
+    }
+
+    std::vector<std::pair<int, Move>> ordered;
+    for (int i = 0; i < (int)rootMoves.size(); i++) {
+        ordered.push_back({rootScores[i], rootMoves[i]});
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (int i = 0; i < (int)rootMoves.size(); i++) {
+        rootMoves[i] = ordered[i].second;
+    }
+
     return score;
 }
 
-extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistoryStr, int maxDepth, bool isWhite)
+// Odd helpers run one ply deeper and each helper starts the root from a different move, so threads diverge
+void HelperSearch(BoardPosition position, std::vector<Move> rootMoves, int maxDepth, int threadIndex) {
+    searchThreadIndex = threadIndex;
+    undoDepth = 0;
+    if (rootMoves.empty()) return;
+
+    int depthOffset = threadIndex & 1;
+    std::rotate(rootMoves.begin(), rootMoves.begin() + threadIndex % rootMoves.size(), rootMoves.end());
+
+    try {
+        int previousScore = 0;
+        for (int currentDepth = 1 + depthOffset; currentDepth <= customMin(maxDepth + depthOffset, MAX_SEARCH_DEPTH); currentDepth++) {
+            Move bestMove;
+            previousScore = AspirationSearch(position, rootMoves, currentDepth, previousScore, bestMove);
+        }
+    } catch (const std::runtime_error&) {
+        while (undoDepth > 0) {
+            UnmakeMove(position);
+        }
+    }
+}
+
+// Helper threads stay parked between searches, so their thread_local history, pawn and material tables carry over
+class SearchHelperPool {
+public:
+    // Wakes searchThreadCount - 1 helpers on the given root; returns at once
+    void Start(const BoardPosition& position, const std::vector<Move>& rootMoves, int maxDepth, ChessPersonality personality) {
+        Resize(searchThreadCount - 1);
+        if (workers.empty()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobPosition = position;
+            jobMoves = rootMoves;
+            jobDepth = maxDepth;
+            jobPersonality = personality;
+            running = (int)workers.size();
+            stopHelpers = false;
+            searchGeneration++;
+        }
+        wake.notify_all();
+    }
+
+    // Signals the helpers to abandon the search and waits until every one of them is parked again
+    void Stop() {
+        stopHelpers = true;
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return running == 0; });
+    }
+
+private:
+    void Resize(int count) {
+        if ((int)workers.size() == count) return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            exiting = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        exiting = false;
+
+        for (int i = 1; i <= count; i++) {
+            workers.emplace_back(&SearchHelperPool::WorkerLoop, this, i, searchGeneration);
+        }
+    }
+
+    void WorkerLoop(int threadIndex, uint64_t seenGeneration) {
+        while (true) {
+            BoardPosition position;
+            std::vector<Move> rootMoves;
+            int maxDepth;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return exiting || searchGeneration != seenGeneration; });
+                if (exiting) return;
+                seenGeneration = searchGeneration;
+                position = jobPosition;
+                rootMoves = jobMoves;
+                maxDepth = jobDepth;
+                currentPersonality = jobPersonality;
+            }
+
+            AgeHistoryTables();
+            SnapshotPruningParameters();
+            HelperSearch(position, rootMoves, maxDepth, threadIndex);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) idle.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    uint64_t searchGeneration = 0;
+    int running = 0;
+    bool exiting = false;
+    BoardPosition jobPosition;
+    std::vector<Move> jobMoves;
+    int jobDepth = 0;
+    ChessPersonality jobPersonality = STANDARD;
+};
+
+// Leaked at exit for the same reason as the analysis pool
+SearchHelperPool* searchHelpers = new SearchHelperPool();
+
+CHESSENGINE_API const char* GetBestMove(const char* moveHistoryStr, int maxDepth, bool isWhite)
 {
-    maxDepth = customMin(maxDepth, 3);
+    maxDepth = customMin(maxDepth, MAX_SEARCH_DEPTH);
 
     std::string moveHistory(moveHistoryStr);
 
+    currentPersonality = selectedPersonality;
     ChessPersonality originalPersonality = currentPersonality;
     
     if (originalPersonality != STANDARD) {
@@ -3012,29 +4288,19 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
         return errorResult.c_str();
     }
 
-    PrintBoard(currentPosition.boardState);
+    PrintBoard(currentPosition);
 
     auto startTime = std::chrono::high_resolution_clock::now();
     const int MAX_SEARCH_TIME_MS = 10000;
     const int ABSOLUTE_FAILSAFE_TIME_MS = 20000;
 
-    for (auto& entry : transpositionTable) {
-        entry = TTEntry();
-    }
-    
-    if (evaluationCache.size() > MAX_EVAL_CACHE_SIZE/5) {
-        evaluationCache.clear();
-    }
-
-    std::vector<Move> allMoves = GenerateMoves(currentPosition, currentPosition.whiteToMove);
+    ttGeneration = (ttGeneration + 1) & 63;
+    AgeHistoryTables();
 
-    std::vector<Move> legalMoves;
-    for (const Move& move : allMoves) {
-        BoardPosition newPosition = ApplyMove(currentPosition, move);
-        if (!IsKingInCheck(newPosition, currentPosition.whiteToMove)) {
-            legalMoves.push_back(move);
-        }
-    }
+    MoveList rootMoves;
+    GenerateLegalMoves(currentPosition, currentPosition.whiteToMove, rootMoves);
+    std::vector<Move> allMoves(rootMoves.begin(), rootMoves.end());
+    std::vector<Move> legalMoves = allMoves;
 
     if (legalMoves.empty()) {
         static std::string noMoveResult = "error";
@@ -3048,9 +4314,9 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
         switch (originalPersonality) {
             case AGGRESSIVE:
                 for (const Move& move : legalMoves) {
-                    if (move.notation.length() >= 5) {
-                        int startPos = std::stoi(move.notation.substr(1, 2));
-                        int endPos = std::stoi(move.notation.substr(3, 2));
+                    if (!move.IsNull()) {
+                        int startPos = move.From();
+                        int endPos = move.To();
                         int startRank = startPos / 8;
                         int endRank = endPos / 8;
                         
@@ -3068,8 +4334,8 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 
             case POSITIONAL:
                 for (const Move& move : legalMoves) {
-                    if (move.notation.length() >= 5) {
-                        int endPos = std::stoi(move.notation.substr(3, 2));
+                    if (!move.IsNull()) {
+                        int endPos = move.To();
                         int endRank = endPos / 8;
                         int endFile = endPos % 8;
                         
@@ -3085,16 +4351,14 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 
             case SOLID:
                 for (const Move& move : legalMoves) {
-                    if (move.notation.length() >= 5) {
-                        int startPos = std::stoi(move.notation.substr(1, 2));
-                        int endPos = std::stoi(move.notation.substr(3, 2));
-                        int startRank = startPos / 8;
+                    if (!move.IsNull()) {
+                        int endPos = move.To();
                         int endRank = endPos / 8;
                         
                         bool isDefensive = (currentPosition.whiteToMove) ? 
                             (endRank >= 4) : (endRank <= 3);
                             
-                        bool isCastling = move.isCastling;
+                        bool isCastling = move.IsCastling();
                         
                         if (isDefensive || isCastling) {
                             filteredMoves.push_back(move);
@@ -3115,9 +4379,9 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 }
                 
                 for (const Move& move : legalMoves) {
-                    if (move.notation.length() >= 5) {
-                        int startPos = std::stoi(move.notation.substr(1, 2));
-                        int endPos = std::stoi(move.notation.substr(3, 2));
+                    if (!move.IsNull()) {
+                        int startPos = move.From();
+                        int endPos = move.To();
                         int startRank = startPos / 8;
                         int endRank = endPos / 8;
                         
@@ -3161,39 +4425,37 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
             bool removeBadMove = false;
             
             if (currentPosition.whiteToMove) {
-                if (it->notation == "P4840") {
+                if (*it == Move(48, 40) && currentPosition.boardState[48] == 'P') {
                     std::cout << "Filtering out a2a3" << std::endl;
                     removeBadMove = true;
                 }
-                else if (it->notation == "P5547") {
+                else if (*it == Move(55, 47) && currentPosition.boardState[55] == 'P') {
                     std::cout << "Filtering out h2h3" << std::endl;
                     removeBadMove = true;
                 }
-                else if (it->notation[0] == 'N') {
-                    int endPos = std::stoi(it->notation.substr(3, 2));
-                    int file = endPos % 8;
+                else if (currentPosition.boardState[it->From()] == 'N') {
+                    int file = it->To() % 8;
                     if (file == 0 || file == 7) {
-                        std::cout << "Filtering out knight move to edge: " << it->notation << std::endl;
+                        std::cout << "Filtering out knight move to edge: " << ConvertToAlgebraic(*it, currentPosition) << std::endl;
                         removeBadMove = true;
                     }
                 }
             }
             else {
-                if (it->notation == "n0116" && 
+                if (*it == Move(1, 16) && currentPosition.boardState[1] == 'n' &&
                     (moveHistory == "e2e4" || moveHistory == "e4")) {
                     std::cout << "Filtering out Na6 response to e4" << std::endl;
                     removeBadMove = true;
                 }
-                else if (it->notation == "n0623" && 
+                else if (*it == Move(6, 23) && currentPosition.boardState[6] == 'n' &&
                     (moveHistory == "e2e4" || moveHistory == "e4")) {
                     std::cout << "Filtering out Nh6 response to e4" << std::endl;
                     removeBadMove = true;
                 }
-                else if (it->notation[0] == 'n') {
-                    int endPos = std::stoi(it->notation.substr(3, 2));
-                    int file = endPos % 8;
+                else if (currentPosition.boardState[it->From()] == 'n') {
+                    int file = it->To() % 8;
                     if (file == 0 || file == 7) {
-                        std::cout << "Filtering out knight move to edge: " << it->notation << std::endl;
+                        std::cout << "Filtering out knight move to edge: " << ConvertToAlgebraic(*it, currentPosition) << std::endl;
                         removeBadMove = true;
                     }
                 }
@@ -3208,52 +4470,56 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
         
         std::cout << "Legal moves after filtering:" << std::endl;
         for (const Move& move : legalMoves) {
-            std::cout << "  " << move.notation << " -> " 
-                      << ConvertToAlgebraic(move, currentPosition) << std::endl;
+            std::cout << "  " << ConvertToAlgebraic(move, currentPosition) << std::endl;
         }
         
         if (legalMoves.empty() && initialMoveCount > 0) {
             std::cout << "Warning: Filtered all moves, restoring legal ones" << std::endl;
             legalMoves = allMoves;
-            for (auto it = legalMoves.begin(); it != legalMoves.end();) {
-                BoardPosition newPosition = ApplyMove(currentPosition, *it);
-                if (IsKingInCheck(newPosition, !currentPosition.whiteToMove)) {
-                    it = legalMoves.erase(it);
-                } else {
-                    ++it;
-                }
-            }
         }
 
         if (legalMoves.size() > 1) {
-            auto blunderIter = std::remove_if(legalMoves.begin(), legalMoves.end(),
-                [&currentPosition](const Move& move) { 
-                    return IsTacticalBlunder(currentPosition, move); 
-                });
-    
-            if (blunderIter != legalMoves.begin()) {
-                int numBlunders = std::distance(blunderIter, legalMoves.end());
-                if (numBlunders > 0 && blunderIter != legalMoves.end()) {
-                    std::cout << "Am filtrat " << numBlunders << " mutări tactice proaste!" << std::endl;
-                    legalMoves.erase(blunderIter, legalMoves.end());
-                }
+            std::vector<char> isBlunder(legalMoves.size());
+            std::vector<std::string> diagnostics(legalMoves.size());
+            AnalysisPool().ParallelFor((int)legalMoves.size(), [&, personality = currentPersonality](int i) {
+                currentPersonality = personality;
+                BoardPosition position = currentPosition;
+                isBlunder[i] = IsTacticalBlunder(position, legalMoves[i], &diagnostics[i]);
+            });
+            for (const std::string& diagnostic : diagnostics) {
+                if (!diagnostic.empty()) std::cout << diagnostic << std::endl;
+            }
+
+            std::vector<Move> safeMoves;
+            for (int i = 0; i < (int)legalMoves.size(); i++) {
+                if (!isBlunder[i]) safeMoves.push_back(legalMoves[i]);
+            }
+    
+            int numBlunders = legalMoves.size() - safeMoves.size();
+            if (!safeMoves.empty() && numBlunders > 0) {
+                std::cout << "Am filtrat " << numBlunders << " mutări tactice proaste!" << std::endl;
+                legalMoves = safeMoves;
             }
         }
         
         if (legalMoves.size() > 1) {
-            std::vector<std::pair<int, Move>> scoredMoves;
-            for (const Move& move : legalMoves) {
-                BoardPosition newPos = ApplyMove(currentPosition, move);
+            std::vector<std::pair<int, Move>> scoredMoves(legalMoves.size());
+            AnalysisPool().ParallelFor((int)legalMoves.size(), [&, personality = currentPersonality](int i) {
+                currentPersonality = personality;
+                BoardPosition newPos = ApplyMove(currentPosition, legalMoves[i]);
 
                 newPos.whiteToMove = currentPosition.whiteToMove;
+                newPos.hash ^= zobristSide;
                 int score = EvaluateBoard(newPos, 0);
 
                 if (!currentPosition.whiteToMove) {
                     score = -score;
                 }
-                scoredMoves.push_back({score, move});
-                std::cout << "  Evaluated " << ConvertToAlgebraic(move, currentPosition) 
-                          << " = " << score << std::endl;
+                scoredMoves[i] = {score, legalMoves[i]};
+            });
+            for (const auto& scoredMove : scoredMoves) {
+                std::cout << "  Evaluated " << ConvertToAlgebraic(scoredMove.second, currentPosition) 
+                          << " = " << scoredMove.first << std::endl;
             }
 
             if (currentPosition.fullMoveNumber == 1 && currentPosition.whiteToMove) {
@@ -3290,7 +4556,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 [](const auto& a, const auto& b) { return a.first > b.first; });
             
             int keepCount = customMax(1, (int)(scoredMoves.size() / 2));
-            if (scoredMoves.size() > keepCount) {
+            if ((int)scoredMoves.size() > keepCount) {
                 scoredMoves.resize(keepCount);
             }
             
@@ -3303,46 +4569,35 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
 
     const int FIXED_TIME_LIMIT_MS = 10000;
     startTime = std::chrono::high_resolution_clock::now();
+    searchStartTime = startTime;
 
-    for (int currentDepth = 1; currentDepth <= maxDepth; currentDepth++) {
-        MoveTreeNode* root = new MoveTreeNode(currentPosition.boardState);
-        
-        for (const Move& move : legalMoves) {
-            BoardPosition newPosition = ApplyMove(currentPosition, move);
-            MoveTreeNode* child = new MoveTreeNode(newPosition.boardState, move, root);
-            
-            if (currentDepth > 1) {
-                ExpandNode(child, currentDepth-1, !currentPosition.whiteToMove, newPosition);
-            }
-            
-            root->children.push_back(child);
-        }
+    SnapshotPruningParameters();
+    searchHelpers->Start(currentPosition, legalMoves, maxDepth, currentPersonality);
 
-        int bestValue = -2147483647;
+    std::vector<Move> searchMoves = legalMoves;
+    int previousScore = 0;
+
+    for (int currentDepth = 1; currentDepth <= maxDepth; currentDepth++) {
+        int bestValue;
         Move currentBestMove;
-        bool moveFound = false;
 
         try {
-            for (MoveTreeNode* childNode : root->children) {
-                int moveValue = -MinimaxOnTree(childNode, currentDepth - 1, -2147483647, 2147483647, !currentPosition.whiteToMove, true);
-        
-                if (moveValue > bestValue) {
-                    bestValue = moveValue;
-                    currentBestMove = childNode->move;
-                    moveFound = true;
-                }
-            }
+            bestValue = AspirationSearch(currentPosition, searchMoves, currentDepth, previousScore, currentBestMove);
         }
         catch (const std::runtime_error& e) {
             std::cout << "Căutare întreruptă: " << e.what() << std::endl;
-            if (moveFound) {
+            while (undoDepth > 0) {
+                UnmakeMove(currentPosition);
+            }
+            if (!currentBestMove.IsNull()) {
                 bestMove = currentBestMove;
                 hasBestMove = true;
             }
             break;
         }
 
-        if (moveFound) {
+        previousScore = bestValue;
+        if (!currentBestMove.IsNull()) {
             bestMove = currentBestMove;
             hasBestMove = true;
 
@@ -3351,8 +4606,6 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
             }
         }
 
-        delete root;
-
         auto currentTime = std::chrono::high_resolution_clock::now();
         auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count();
         if (elapsedMs > MAX_SEARCH_TIME_MS) {
@@ -3376,41 +4629,45 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
         }
     }
 
+    searchHelpers->Stop();
+
     if (originalPersonality != STANDARD) {
         std::cout << "Restoring " << (int)originalPersonality << " personality for final move selection" << std::endl;
         currentPersonality = originalPersonality;
     }
 
     if (currentPersonality != STANDARD && !legalMoves.empty()) {
-        std::vector<std::pair<int, Move>> finalEvaluation;
-    
-        for (const Move& move : legalMoves) {
-            BoardPosition newPos = ApplyMove(currentPosition, move);
+        std::vector<std::pair<int, Move>> finalEvaluation(legalMoves.size());
+        std::vector<int> centralityScores(legalMoves.size());
+
+        bool isEarlyGame = (currentPosition.fullMoveNumber <= 10);
         
-            int score = EvaluateBoard(newPos, 1);
+        const int PERSONALITY_FACTOR = 50;
+        AnalysisPool().ParallelFor((int)legalMoves.size(), [&, personality = currentPersonality](int i) {
+            currentPersonality = personality;
+            BoardPosition position = currentPosition;
+            const Move& move = legalMoves[i];
+            auto& eval = finalEvaluation[i];
+
+            MakeMove(position, move);
+            int score = EvaluateBoard(position, 1);
+            UnmakeMove(position);
         
-            if (!currentPosition.whiteToMove) {
+            if (!position.whiteToMove) {
                 score = -score;
             }
         
-            finalEvaluation.push_back({score, move});
-        }
-
-        bool isEarlyGame = (currentPosition.fullMoveNumber <= 10);
-        
-        const int PERSONALITY_FACTOR = 50;
-    
-        for (auto& eval : finalEvaluation) {
-            int startPos = std::stoi(eval.second.notation.substr(1, 2));
-            int endPos = std::stoi(eval.second.notation.substr(3, 2));
-            char piece = eval.second.notation[0];
+            eval = {score, move};
+            int startPos = eval.second.From();
+            int endPos = eval.second.To();
+            char piece = position.boardState[eval.second.From()];
             int startRank = startPos / 8;
             int endRank = endPos / 8;
             int endFile = endPos % 8;
-            bool isAdvancing = (currentPosition.whiteToMove) ? 
+            bool isAdvancing = (position.whiteToMove) ? 
                 (endRank < startRank) : (endRank > startRank);
             
-            int centralityScore = GetCentralityScore(eval.second, isEarlyGame);
+            int centralityScore = GetCentralityScore(position, eval.second, isEarlyGame);
         
             switch (currentPersonality) {
                 case AGGRESSIVE:
@@ -3418,20 +4675,17 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                         centralityScore += 250 * PERSONALITY_FACTOR;
                     }
                 
-                    if ((currentPosition.whiteToMove && endRank < 4) || 
-                        (!currentPosition.whiteToMove && endRank > 3)) {
+                    if ((position.whiteToMove && endRank < 4) || 
+                        (!position.whiteToMove && endRank > 3)) {
                         centralityScore += 200 * PERSONALITY_FACTOR;
                     }
                     
-                    if (currentPosition.boardState[endPos] != ' ') {
+                    if (position.boardState[endPos] != ' ') {
                         centralityScore += 300 * PERSONALITY_FACTOR;
                     }
                     
-                    {
-                        BoardPosition afterMove = ApplyMove(currentPosition, eval.second);
-                        if (IsKingInCheck(afterMove, !currentPosition.whiteToMove)) {
-                            centralityScore += 400 * PERSONALITY_FACTOR;
-                        }
+                    if (IsCheck(position, eval.second)) {
+                        centralityScore += 400 * PERSONALITY_FACTOR;
                     }
                     break;
                 
@@ -3458,33 +4712,22 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 case SOLID:
                     centralityScore /= 4;
                 
-                    if ((currentPosition.whiteToMove && endRank < 3) || 
-                        (!currentPosition.whiteToMove && endRank > 4)) {
+                    if ((position.whiteToMove && endRank < 3) || 
+                        (!position.whiteToMove && endRank > 4)) {
                         centralityScore -= 300 * PERSONALITY_FACTOR;
                     }
                 
-                    if ((currentPosition.whiteToMove && endRank > 5) || 
-                        (!currentPosition.whiteToMove && endRank < 2)) {
+                    if ((position.whiteToMove && endRank > 5) || 
+                        (!position.whiteToMove && endRank < 2)) {
                         eval.first += 350 * PERSONALITY_FACTOR;
                     }
                     
-                    if (eval.second.isCastling) {
+                    if (eval.second.IsCastling()) {
                         eval.first += 500 * PERSONALITY_FACTOR;
                     }
                     
                     {
-                        BoardPosition afterMove = ApplyMove(currentPosition, eval.second);
-                        int protectionCount = 0;
-                        
-                        for (int i = 0; i < 64; i++) {
-                            char p = afterMove.boardState[i];
-                            if (p != ' ' && ((currentPosition.whiteToMove && isupper(p)) ||
-                                            (!currentPosition.whiteToMove && islower(p)))) {
-                                if (i != endPos && IsSquareAttacked(afterMove, i, currentPosition.whiteToMove)) {
-                                    protectionCount++;
-                                }
-                            }
-                        }
+                        int protectionCount = CountProtectedPieces(position, eval.second);
                         
                         if (protectionCount > 0) {
                             eval.first += 200 * protectionCount * PERSONALITY_FACTOR;
@@ -3492,12 +4735,12 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     }
                     break;
                 
-                case DYNAMIC:
+                case DYNAMIC: {
                     int tension = 0;
                     for (int i = 0; i < 64; i++) {
-                        char p = currentPosition.boardState[i];
+                        char p = position.boardState[i];
                         if (p != ' ') {
-                            if (IsSquareAttacked(currentPosition, i, !isupper(p))) {
+                            if (IsSquareAttacked(position, i, !isupper(p))) {
                                 tension++;
                             }
                         }
@@ -3506,7 +4749,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     if (tension > 3) {
                         if (isAdvancing) {
                             centralityScore += 150 * PERSONALITY_FACTOR;
-                        } else if (currentPosition.boardState[endPos] != ' ') {
+                        } else if (position.boardState[endPos] != ' ') {
                             centralityScore += 200 * PERSONALITY_FACTOR;
                         } else {
                             centralityScore += 100 * PERSONALITY_FACTOR;
@@ -3515,13 +4758,20 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                         centralityScore += 180 * PERSONALITY_FACTOR;
                         
                         {
-                            BoardPosition afterMove = ApplyMove(currentPosition, eval.second);
-                            std::vector<Move> futureMoves = GenerateMoves(afterMove, currentPosition.whiteToMove);
+                            bool isWhiteMove = position.whiteToMove;
+                            MakeMove(position, eval.second);
+                            MoveList futureMoves;
+                            GenerateMoves(position, isWhiteMove, futureMoves);
+                            UnmakeMove(position);
                             
                             eval.first += futureMoves.size() * 25 * PERSONALITY_FACTOR;
                         }
                     }
                     break;
+                }
+
+                default:
+                    break;
             }
         
             if (isEarlyGame) {
@@ -3532,10 +4782,13 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
             }
             
             eval.first += centralityScore;
-        
+            centralityScores[i] = centralityScore;
+        });
+
+        for (int i = 0; i < (int)finalEvaluation.size(); i++) {
             std::cout << "Eval with " << (int)currentPersonality 
-                    << " personality: " << ConvertToAlgebraic(eval.second, currentPosition) 
-                    << " = " << eval.first << " (centrality: " << centralityScore << ")" << std::endl;
+                    << " personality: " << ConvertToAlgebraic(finalEvaluation[i].second, currentPosition) 
+                    << " = " << finalEvaluation[i].first << " (centrality: " << centralityScores[i] << ")" << std::endl;
         }
     
         std::sort(finalEvaluation.begin(), finalEvaluation.end(),
@@ -3558,9 +4811,8 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 bool foundGoodMove = false;
     
                 for (const auto& evalMove : finalEvaluation) {
-                    int startPos = std::stoi(evalMove.second.notation.substr(1, 2));
-                    int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
-                    char piece = evalMove.second.notation[0];
+                    int endPos = evalMove.second.To();
+                    char piece = currentPosition.boardState[evalMove.second.From()];
         
                     if (tolower(piece) == 'n' && endPos == 36) {
                         for (int i = 0; i < 64; i++) {
@@ -3579,8 +4831,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                         }
                     }
         
-                    BoardPosition afterMove = ApplyMove(currentPosition, evalMove.second);
-                    bool givesCheck = IsKingInCheck(afterMove, !currentPosition.whiteToMove);
+                    bool givesCheck = IsCheck(currentPosition, evalMove.second);
         
                     if (givesCheck && IsMoveSafe(currentPosition, evalMove.second)) {
                         bestMove = evalMove.second;
@@ -3592,9 +4843,8 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
     
                 if (!foundGoodMove) {
                     for (const auto& evalMove : finalEvaluation) {
-                        int startPos = std::stoi(evalMove.second.notation.substr(1, 2));
-                        int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
-                        char piece = evalMove.second.notation[0];
+                        int endPos = evalMove.second.To();
+                        char piece = currentPosition.boardState[evalMove.second.From()];
                         bool isCapture = (currentPosition.boardState[endPos] != ' ');
             
                         if (tolower(piece) == 'n' && endPos == 36) {
@@ -3629,8 +4879,8 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
     
                 if (!foundGoodMove) {
                     for (const auto& evalMove : finalEvaluation) {
-                        int startPos = std::stoi(evalMove.second.notation.substr(1, 2));
-                        int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
+                        int startPos = evalMove.second.From();
+                        int endPos = evalMove.second.To();
                         int startRank = startPos / 8;
                         int endRank = endPos / 8;
             
@@ -3652,7 +4902,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
             }
             else if (currentPersonality == POSITIONAL && finalEvaluation.size() > 1) {
                 for (const auto& evalMove : finalEvaluation) {
-                    int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
+                    int endPos = evalMove.second.To();
                     int endRank = endPos / 8;
                     int endFile = endPos % 8;
                     
@@ -3668,7 +4918,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 
                 bool foundCentralMove = false;
                 for (const auto& evalMove : finalEvaluation) {
-                    char piece = evalMove.second.notation[0];
+                    char piece = currentPosition.boardState[evalMove.second.From()];
                     
                     if (tolower(piece) == 'b') {
                         bestMove = evalMove.second;
@@ -3680,7 +4930,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 
                 if (!foundCentralMove) {
                     for (const auto& evalMove : finalEvaluation) {
-                        int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
+                        int endPos = evalMove.second.To();
                         int endRank = endPos / 8;
                         int endFile = endPos % 8;
                         
@@ -3698,7 +4948,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
             else if (currentPersonality == SOLID && finalEvaluation.size() > 1) {
                 bool foundCastling = false;
                 for (const auto& evalMove : finalEvaluation) {
-                    if (evalMove.second.isCastling) {
+                    if (evalMove.second.IsCastling()) {
                         bestMove = evalMove.second;
                         std::cout << "SOLID override: Preferring castling (absolute priority)" << std::endl;
                         foundCastling = true;
@@ -3709,26 +4959,14 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                 if (!foundCastling) {
                     bool foundDefensive = false;
                     for (const auto& evalMove : finalEvaluation) {
-                        int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
-                        int startPos = std::stoi(evalMove.second.notation.substr(1, 2));
+                        int endPos = evalMove.second.To();
                         int endRank = endPos / 8;
                         
                         bool isDefensive = (currentPosition.whiteToMove) ? 
                             (endRank >= 4) : (endRank <= 3);
                             
                         if (isDefensive) {
-                            BoardPosition afterMove = ApplyMove(currentPosition, evalMove.second);
-                            int protectionCount = 0;
-                            
-                            for (int i = 0; i < 64; i++) {
-                                char p = afterMove.boardState[i];
-                                if (p != ' ' && ((currentPosition.whiteToMove && isupper(p)) ||
-                                                (!currentPosition.whiteToMove && islower(p)))) {
-                                    if (i != endPos && IsSquareAttacked(afterMove, i, currentPosition.whiteToMove)) {
-                                        protectionCount++;
-                                    }
-                                }
-                            }
+                            int protectionCount = CountProtectedPieces(currentPosition, evalMove.second);
                             
                             if (protectionCount > 0) {
                                 bestMove = evalMove.second;
@@ -3742,7 +4980,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     
                     if (!foundDefensive) {
                         for (const auto& evalMove : finalEvaluation) {
-                            int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
+                            int endPos = evalMove.second.To();
                             int endRank = endPos / 8;
                             
                             bool staySafe = (currentPosition.whiteToMove) ? 
@@ -3774,11 +5012,10 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     
                     bool foundTactical = false;
                     for (const auto& evalMove : finalEvaluation) {
-                        int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
+                        int endPos = evalMove.second.To();
                         bool isCapture = (currentPosition.boardState[endPos] != ' ');
                         
-                        BoardPosition afterMove = ApplyMove(currentPosition, evalMove.second);
-                        bool givesCheck = IsKingInCheck(afterMove, !currentPosition.whiteToMove);
+                        bool givesCheck = IsCheck(currentPosition, evalMove.second);
                         
                         if (givesCheck || isCapture) {
                             bestMove = evalMove.second;
@@ -3793,8 +5030,10 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                         Move bestMobilityMove;
                         
                         for (const auto& evalMove : finalEvaluation) {
-                            BoardPosition afterMove = ApplyMove(currentPosition, evalMove.second);
-                            std::vector<Move> futureMoves = GenerateMoves(afterMove, afterMove.whiteToMove);
+                            MakeMove(currentPosition, evalMove.second);
+                            MoveList futureMoves;
+                            GenerateMoves(currentPosition, currentPosition.whiteToMove, futureMoves);
+                            UnmakeMove(currentPosition);
                             
                             if ((int)futureMoves.size() > bestMobility) {
                                 bestMobility = futureMoves.size();
@@ -3813,7 +5052,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     
                     bool foundPositional = false;
                     for (const auto& evalMove : finalEvaluation) {
-                        int endPos = std::stoi(evalMove.second.notation.substr(3, 2));
+                        int endPos = evalMove.second.To();
                         int endRank = endPos / 8;
                         int endFile = endPos % 8;
                         
@@ -3830,8 +5069,8 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     
                     if (!foundPositional && isEarlyGame) {
                         for (const auto& evalMove : finalEvaluation) {
-                            char piece = evalMove.second.notation[0];
-                            int startPos = std::stoi(evalMove.second.notation.substr(1, 2));
+                            char piece = currentPosition.boardState[evalMove.second.From()];
+                            int startPos = evalMove.second.From();
                             int startRank = startPos / 8;
                             
                             bool isDevelopment = (currentPosition.whiteToMove && 
@@ -3855,9 +5094,9 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
                     << ConvertToAlgebraic(bestMove, currentPosition) << std::endl;
         }
     }
-    if (hasBestMove && bestMove.notation.length() >= 5) {
-        int endPos = std::stoi(bestMove.notation.substr(3, 2));
-        bool isCapture = (currentPosition.boardState[endPos] != ' ' || bestMove.isEnPassant);
+    if (hasBestMove && !bestMove.IsNull()) {
+        int endPos = bestMove.To();
+        bool isCapture = (currentPosition.boardState[endPos] != ' ' || bestMove.IsEnPassant());
         
         bool skipSafetyCheck = (currentPersonality == AGGRESSIVE || isCapture);
         
@@ -3867,9 +5106,9 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
         
             bool foundSafeMove = false;
             for (const Move& move : legalMoves) {
-                if (move.notation != bestMove.notation) {
-                    int moveEndPos = std::stoi(move.notation.substr(3, 2));
-                    bool isMoveCapture = (currentPosition.boardState[moveEndPos] != ' ' || move.isEnPassant);
+                if (move != bestMove) {
+                    int moveEndPos = move.To();
+                    bool isMoveCapture = (currentPosition.boardState[moveEndPos] != ' ' || move.IsEnPassant());
                     
                     if (isMoveCapture || IsMoveSafe(currentPosition, move)) {
                         bestMove = move;
@@ -3892,20 +5131,21 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
     static std::string result;
     
     if (hasBestMove) {
-        if (bestMove.notation.length() >= 5) {
+        if (!bestMove.IsNull()) {
             result = ConvertToAlgebraic(bestMove, currentPosition);
         } else {
             std::vector<std::pair<int, Move>> scoredMoves;
             for (const Move& move : legalMoves) {
-                if (move.notation.length() >= 5) {
-                    BoardPosition newPos = ApplyMove(currentPosition, move);
-                    int score = EvaluateBoard(newPos, 0);
+                if (!move.IsNull()) {
+                    MakeMove(currentPosition, move);
+                    int score = EvaluateBoard(currentPosition, 0);
+                    UnmakeMove(currentPosition);
                     if (!currentPosition.whiteToMove) {
                         score = -score;
                     }
                     
                     bool isEarlyGame = (currentPosition.fullMoveNumber <= 10);
-                    int centralityScore = GetCentralityScore(move, isEarlyGame);
+                    int centralityScore = GetCentralityScore(currentPosition, move, isEarlyGame);
                     score += centralityScore;
                     
                     scoredMoves.push_back({score, move});
@@ -3930,7 +5170,7 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
         std::cout << "WARNING: Engine returned 'error' despite having legal moves. Using fallback." << std::endl;
         
         for (const Move& move : legalMoves) {
-            if (move.notation.length() >= 5) {
+            if (!move.IsNull()) {
                 result = ConvertToAlgebraic(move, currentPosition);
                 std::cout << "Fallback move selected: " << result << std::endl;
                 break;
@@ -3943,16 +5183,274 @@ extern "C" __declspec(dllexport) const char* GetBestMove(const char* moveHistory
     return result.c_str();
 }
 
-extern "C" __declspec(dllexport) void SetEnginePersonality(int personalityType) {
+CHESSENGINE_API bool SetHashSizeMB(int sizeMB) {
+    if (sizeMB < 1) sizeMB = 1;
+    bool resized = ResizeTranspositionTable((size_t)sizeMB);
+    if (!resized) {
+        std::cerr << "Could not allocate " << sizeMB << " MB hash, keeping " << ttBucketCount * sizeof(TTBucket) / (1024 * 1024) << " MB" << std::endl;
+    }
+    return resized;
+}
+
+CHESSENGINE_API void SetThreadCount(int threadCount) {
+    searchThreadCount = customMax(1, customMin(threadCount, MAX_SEARCH_THREADS));
+}
+
+// Names: ReverseFutilityMargin, FutilityMargin, RazorMargin, LateMoveCount, LateMoveCountImproving
+CHESSENGINE_API bool SetPruningParameter(const char* name, int depth, int value) {
+    if (name == nullptr || depth < 0 || depth > PRUNING_DEPTH || value < 0) return false;
+
+    std::string parameter = name;
+    std::lock_guard<std::mutex> lock(pruningParametersMutex);
+    if (parameter == "ReverseFutilityMargin") {
+        pruningParameters.reverseFutilityMargin[depth] = value;
+    } else if (parameter == "FutilityMargin") {
+        pruningParameters.futilityMargin[depth] = value;
+    } else if (parameter == "RazorMargin") {
+        pruningParameters.razorMargin[depth] = value;
+    } else if (parameter == "LateMoveCount") {
+        pruningParameters.lateMoveCount[0][depth] = value;
+    } else if (parameter == "LateMoveCountImproving") {
+        pruningParameters.lateMoveCount[1][depth] = value;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+CHESSENGINE_API void NewGame() {
+    gameKeySalt = MagicRandom(gameSaltSeed);
+    ttGeneration = (ttGeneration + 1) & 63;
+}
+
+CHESSENGINE_API void SetEnginePersonality(int personalityType) {
     if (personalityType >= STANDARD && personalityType <= DYNAMIC) {
-        currentPersonality = static_cast<ChessPersonality>(personalityType);
+        selectedPersonality = static_cast<ChessPersonality>(personalityType);
+        currentPersonality = selectedPersonality;
         std::cout << "Engine personality set to: " << personalityType << std::endl;
     } else {
         std::cout << "Invalid personality type: " << personalityType << std::endl;
     }
 }
 
-void PrintMoveTree(MoveTreeNode* node, int depth = 0) {
+// --- Start of Perft --- \\
+
+struct PerftEntry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> nodes;
+};
+
+std::unique_ptr<PerftEntry[]> perftTable;
+size_t perftTableSize = 0;
+
+uint64_t PerftKey(const BoardPosition& position, int depth) {
+    return position.hash ^ ((uint64_t)depth * 0xD6E8FEB86659FD93ULL);
+}
+
+void ResizePerftTable(int sizeMB) {
+    perftTable.reset();
+    perftTableSize = 0;
+    if (sizeMB <= 0) return;
+
+    size_t entries = 1;
+    while (entries * 2 * sizeof(PerftEntry) <= (size_t)sizeMB * 1024 * 1024) {
+        entries *= 2;
+    }
+    perftTable.reset(new PerftEntry[entries]());
+    perftTableSize = entries;
+}
+
+// Legal movegen with bulk counting: the last ply is just the size of the move list
+uint64_t PerftCount(BoardPosition& position, int depth) {
+    MoveList moves;
+    GenerateLegalMoves(position, position.whiteToMove, moves);
+    if (depth <= 1) {
+        return depth == 1 ? moves.size() : 1;
+    }
+
+    uint64_t key = 0;
+    PerftEntry* entry = nullptr;
+    if (perftTableSize) {
+        key = PerftKey(position, depth);
+        entry = &perftTable[key & (perftTableSize - 1)];
+        uint64_t nodes = entry->nodes.load(std::memory_order_relaxed);
+        if ((entry->check.load(std::memory_order_relaxed) ^ nodes) == key) {
+            return nodes;
+        }
+    }
+
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        MakeMove(position, move);
+        nodes += PerftCount(position, depth - 1);
+        UnmakeMove(position);
+    }
+
+    if (entry) {
+        entry->check.store(key ^ nodes, std::memory_order_relaxed);
+        entry->nodes.store(nodes, std::memory_order_relaxed);
+    }
+    return nodes;
+}
+
+std::string MoveToCoordinates(const Move& move) {
+    std::string text = IndexToAlgebraic(move.From()) + IndexToAlgebraic(move.To());
+    if (move.IsPromotion()) {
+        text += PieceChar(move.Promotion(), false);
+    }
+    return text;
+}
+
+// Root moves are handed out to the worker threads one at a time, each worker searching its own copy of the position
+uint64_t PerftDivide(const BoardPosition& position, int depth, int threadCount, bool printDivide) {
+    MoveList rootMoves;
+    GenerateLegalMoves(position, position.whiteToMove, rootMoves);
+    if (depth <= 1) {
+        return depth == 1 ? rootMoves.size() : 1;
+    }
+
+    std::vector<uint64_t> moveNodes(rootMoves.size(), 0);
+    std::atomic<int> nextMove(0);
+
+    auto worker = [&]() {
+        BoardPosition local = position;
+        for (int i = nextMove++; i < rootMoves.size(); i = nextMove++) {
+            MakeMove(local, rootMoves[i]);
+            moveNodes[i] = PerftCount(local, depth - 1);
+            UnmakeMove(local);
+        }
+    };
+
+    threadCount = customMax(1, customMin(threadCount, rootMoves.size()));
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < rootMoves.size(); i++) {
+        if (printDivide) {
+            std::cout << MoveToCoordinates(rootMoves[i]) << ": " << moveNodes[i] << std::endl;
+        }
+        total += moveNodes[i];
+    }
+    return total;
+}
+
+// Throws std::invalid_argument for anything that is not a well-formed FEN of a legal position
+BoardPosition ParseFen(const std::string& fen) {
+    std::istringstream fenStream(fen);
+    std::string placement, side, castling, enPassant;
+    int halfMoveClock = 0;
+    int fullMoveNumber = 1;
+    if (!(fenStream >> placement >> side >> castling >> enPassant)) {
+        throw std::invalid_argument("FEN needs placement, side, castling and en passant fields: " + fen);
+    }
+    std::string clockText, moveText, extra;
+    if (fenStream >> clockText) {
+        if (!(fenStream >> moveText) || (fenStream >> extra) ||
+            clockText.find_first_not_of("0123456789") != std::string::npos ||
+            moveText.find_first_not_of("0123456789") != std::string::npos ||
+            clockText.size() > 4 || moveText.size() > 4) {
+            throw std::invalid_argument("Invalid FEN move counters: " + fen);
+        }
+        halfMoveClock = std::stoi(clockText);
+        fullMoveNumber = customMax(1, std::stoi(moveText));
+    }
+
+    std::string board;
+    int rankCount = 1;
+    int rankWidth = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (rankWidth != 8) throw std::invalid_argument("FEN rank does not cover 8 files: " + placement);
+            rankCount++;
+            rankWidth = 0;
+        } else if (c >= '1' && c <= '8') {
+            board += std::string(c - '0', ' ');
+            rankWidth += c - '0';
+        } else if (std::string("PNBRQKpnbrqk").find(c) != std::string::npos) {
+            board += c;
+            rankWidth++;
+        } else {
+            throw std::invalid_argument(std::string("Invalid FEN piece character: ") + c);
+        }
+        if (rankWidth > 8) throw std::invalid_argument("FEN rank does not cover 8 files: " + placement);
+    }
+    if (rankCount != 8 || rankWidth != 8) {
+        throw std::invalid_argument("FEN placement must have 8 ranks of 8 files: " + placement);
+    }
+    if (std::count(board.begin(), board.end(), 'K') != 1 || std::count(board.begin(), board.end(), 'k') != 1) {
+        throw std::invalid_argument("FEN must have exactly one king per side: " + placement);
+    }
+
+    if (side != "w" && side != "b") {
+        throw std::invalid_argument("FEN side to move must be w or b: " + side);
+    }
+    if (castling != "-") {
+        for (size_t i = 0; i < castling.size(); i++) {
+            if (std::string("KQkq").find(castling[i]) == std::string::npos || castling.find(castling[i], i + 1) != std::string::npos) {
+                throw std::invalid_argument("Invalid FEN castling field: " + castling);
+            }
+        }
+    }
+    if (enPassant != "-" && (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+                             enPassant[1] != (side == "w" ? '6' : '3'))) {
+        throw std::invalid_argument("Invalid FEN en passant square: " + enPassant);
+    }
+
+    BoardPosition position;
+    SetupBoard(position, board);
+    position.whiteToMove = side != "b";
+    position.whiteCanCastleKingside = castling.find('K') != std::string::npos;
+    position.whiteCanCastleQueenside = castling.find('Q') != std::string::npos;
+    position.blackCanCastleKingside = castling.find('k') != std::string::npos;
+    position.blackCanCastleQueenside = castling.find('q') != std::string::npos;
+    position.enPassantTargetSquare = (enPassant.size() == 2) ? AlgebraicToIndex(enPassant) : -1;
+    position.halfMoveClock = halfMoveClock;
+    position.fullMoveNumber = fullMoveNumber;
+    position.hash = ComputeZobristKey(position);
+
+    if (IsKingInCheck(position, !position.whiteToMove)) {
+        throw std::invalid_argument("FEN leaves the side not to move in check: " + fen);
+    }
+    return position;
+}
+
+// Accepts either a FEN or the same move history string GetBestMove takes
+CHESSENGINE_API unsigned long long RunPerft(const char* positionStr, int depth, int threadCount, int hashSizeMB, bool divide) {
+    std::string positionText(positionStr ? positionStr : "");
+    BoardPosition position;
+    try {
+        position = positionText.find('/') != std::string::npos ? ParseFen(positionText) : ParseMoveHistory(positionText);
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing perft position: " << e.what() << std::endl;
+        return 0;
+    }
+
+    ResizePerftTable(hashSizeMB);
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    uint64_t nodes = PerftDivide(position, depth, threadCount, divide);
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+
+    std::cout << "Nodes: " << nodes << "  Time: " << elapsedUs / 1000 << " ms  NPS: "
+              << (elapsedUs > 0 ? nodes * 1000000 / elapsedUs : nodes) << std::endl;
+
+    ResizePerftTable(0);
+    return nodes;
+}
+
+// --- End of Perft --- \\
+
+
+void PrintMoveTree(MoveTreeArena& arena, int nodeIndex, int depth = 0) {
+    const MoveTreeNode& node = arena[nodeIndex];
     for (int i = 0; i < depth; i++) {
         std::cout << "  ";
     }
@@ -3960,15 +5458,15 @@ void PrintMoveTree(MoveTreeNode* node, int depth = 0) {
     if (depth == 0) {
         std::cout << "Root: ";
     } else {
-        std::cout << "Move: " << node->move.notation;
-        if (node->isEvaluated) {
-            std::cout << " (Eval: " << node->evaluation << ")";
+        std::cout << "Move: " << IndexToAlgebraic(node.move.From()) << IndexToAlgebraic(node.move.To());
+        if (node.isEvaluated) {
+            std::cout << " (Eval: " << node.evaluation << ")";
         }
     }
     std::cout << std::endl;
     
-    for (MoveTreeNode* child : node->children) {
-        PrintMoveTree(child, depth + 1);
+    for (int child = node.firstChild; child < node.firstChild + node.childCount; child++) {
+        PrintMoveTree(arena, child, depth + 1);
     }
 }
 
@@ -3976,9 +5474,9 @@ void DebugOpeningMoves() {
     /*
     // Test a3 position detection
     BoardPosition testPos;
-    testPos.boardState = "rnbqkbnrpppppppp                                PPPPPPPPR BQKBNR";
-    testPos.boardState[48] = ' '; // Empty a2
-    testPos.boardState[40] = 'P'; // Pawn at a3
+    SetupBoard(testPos, "rnbqkbnrpppppppp                                PPPPPPPPR BQKBNR");
+    RemovePiece(testPos, 48); // Empty a2
+    PutPiece(testPos, 40, 'P'); // Pawn at a3
     testPos.whiteToMove = true;
     testPos.fullMoveNumber = 1;
     
@@ -3986,7 +5484,7 @@ void DebugOpeningMoves() {
     
     // Test e4 position
     BoardPosition e4Pos;
-    e4Pos.boardState = "rnbqkbnrpppppppp                P               PPP PPPPRNBQKBNR";
+    SetupBoard(e4Pos, "rnbqkbnrpppppppp                P               PPP PPPPRNBQKBNR");
     e4Pos.whiteToMove = false;
     e4Pos.fullMoveNumber = 1;
     
@@ -3994,14 +5492,14 @@ void DebugOpeningMoves() {
     
     // Test Na6 after e4
     BoardPosition na6Pos = e4Pos;
-    na6Pos.boardState[1] = ' '; // Knight moved from b8
-    na6Pos.boardState[16] = 'n'; // Knight at a6
+    RemovePiece(na6Pos, 1); // Knight moved from b8
+    PutPiece(na6Pos, 16, 'n'); // Knight at a6
     
     std::cout << "Na6 after e4 evaluation: " << EvaluateOpeningPrinciples(na6Pos) << std::endl;
 
     // Test White's first move selection
     BoardPosition startPos;
-    startPos.boardState = "rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR";
+    SetupBoard(startPos, "rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR");
     startPos.whiteToMove = true;
     startPos.fullMoveNumber = 1;
     startPos.whiteCanCastleKingside = true;
@@ -4014,7 +5512,7 @@ void DebugOpeningMoves() {
     
     // Test Black's response to e4
     BoardPosition e4Pos2;
-    e4Pos2.boardState = "rnbqkbnrpppppppp                P               PPP PPPPRNBQKBNR";
+    SetupBoard(e4Pos2, "rnbqkbnrpppppppp                P               PPP PPPPRNBQKBNR");
     e4Pos2.whiteToMove = false;
     e4Pos2.fullMoveNumber = 1;
     */
@@ -4093,4 +5591,45 @@ int main() {
     * /
     return 0;
 }
-*/
\ No newline at end of file
+*/
+
+#ifdef CHESSENGINE_PERFT_MAIN
+// Built by the perft target of the Makefile next to this file; "make check" verifies the start position
+// usage: perft <depth> [threads] [hashMB] [fen | moves...]
+//        perft material <fen>   prints the endgame scale factors of a position
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <depth> [threads] [hashMB] [fen | moves...]" << std::endl;
+        return 1;
+    }
+
+    if (std::string(argv[1]) == "material") {
+        std::string fen;
+        for (int i = 2; i < argc; i++) {
+            if (!fen.empty()) fen += ' ';
+            fen += argv[i];
+        }
+        try {
+            const MaterialEntry& material = ProbeMaterialTable(ParseFen(fen));
+            std::cout << "Scale: " << (int)material.scale[0] << " " << (int)material.scale[1] << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing position: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    int depth = std::atoi(argv[1]);
+    int threadCount = argc > 2 ? std::atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    int hashSizeMB = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    std::string position;
+    for (int i = 4; i < argc; i++) {
+        if (!position.empty()) position += ' ';
+        position += argv[i];
+    }
+
+    RunPerft(position.c_str(), depth, threadCount, hashSizeMB, true);
+    return 0;
+}
+#endif
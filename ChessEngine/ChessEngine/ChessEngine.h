@@ -1,3 +1,14 @@
 #pragma once
 
-extern "C" __declspec(dllexport) const char* GetBestMove(const char* boardState, int depth, bool isWhite);
+#ifdef _WIN32
+#define CHESSENGINE_API extern "C" __declspec(dllexport)
+#else
+#define CHESSENGINE_API extern "C" __attribute__((visibility("default")))
+#endif
+
+CHESSENGINE_API const char* GetBestMove(const char* boardState, int depth, bool isWhite);
+CHESSENGINE_API bool SetHashSizeMB(int sizeMB);
+CHESSENGINE_API void SetThreadCount(int threadCount);
+CHESSENGINE_API bool SetPruningParameter(const char* name, int depth, int value);
+CHESSENGINE_API void NewGame();
+CHESSENGINE_API unsigned long long RunPerft(const char* position, int depth, int threadCount, int hashSizeMB, bool divide);